@@ -0,0 +1,53 @@
+#!/bin/sh
+
+# Compares the recursive tree-walking engine with the iterative VM on deeply nested programs.
+#
+# Fusion flattens long `;` chains into a loop, so the tree walker runs those at any depth. Nested arguments and
+# self-calling blocks still recurse, so past a few tens of thousands of levels it raises a "nested too deeply" error
+# where the VM keeps going.
+#
+# usage: bench/recursion.sh [executable] [depth...]
+
+knight=${1:-./knight}
+[ $# -gt 0 ] && shift
+depths=${*:-1000 10000 100000}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+# `; = x + x 1 ; = x + x 1 ... O x`: a long chain of statements.
+chain() {
+	printf '; = x 0 '
+	awk -v n="$1" 'BEGIN { for (i = 0; i < n; i++) printf "; = x + x 1 " }'
+	echo 'O x'
+}
+
+# `O + 1 + 1 ... 0`: arguments nested within arguments.
+nested() {
+	printf 'O '
+	awk -v n="$1" 'BEGIN { for (i = 0; i < n; i++) printf "+ 1 " }'
+	echo '0'
+}
+
+# A block that calls itself `depth` times.
+blocks() {
+	echo "; = f B I < n $1 ; = n + n 1 + 1 C f 0 ; = n 0 O C f"
+}
+
+for depth in $depths; do
+	for program in chain nested blocks; do
+		"$program" "$depth" > "$tmp/$program.kn"
+
+		for engine in tree vm; do
+			printf '%-7s depth=%-8s %-5s ' "$program" "$depth" "$engine"
+
+			start=$(date +%s.%N)
+			if "$knight" --engine="$engine" -f "$tmp/$program.kn" >/dev/null 2>&1; then
+				end=$(date +%s.%N)
+				echo "$start $end" | awk '{ printf "%.3fs\n", $2 - $1 }'
+			else
+				echo 'failed (nested too deeply?)'
+			fi
+		done
+	done
+done
@@ -0,0 +1,86 @@
+#include "arena.hpp"
+#include "function.hpp"
+#include "vm.hpp"
+#include "jit.hpp"
+#include <algorithm>
+#include <new>
+
+using namespace kn;
+
+// Bounds for the size of the chunk that's allocated alongside the arena. Programs rarely need more than a few bytes of
+// nodes per byte of source, so it's sized based upon that, which lets most programs fit within a single chunk.
+static constexpr size_t MIN_CHUNK_CAPACITY = 256;
+static constexpr size_t MAX_FIRST_CHUNK_CAPACITY = 1 << 20;
+static constexpr size_t BYTES_PER_SOURCE_BYTE = 8;
+
+Arena::Arena(size_t capacity) noexcept : refcount(1), current(&first), first { nullptr, 0, capacity } {}
+
+Ref<Arena> Arena::create(size_t source_length) {
+	auto capacity = std::clamp(source_length * BYTES_PER_SOURCE_BYTE, MIN_CHUNK_CAPACITY, MAX_FIRST_CHUNK_CAPACITY);
+	auto memory = ::operator new(sizeof(Arena) + capacity);
+
+	return Ref<Arena>(new (memory) Arena(capacity));
+}
+
+Arena::Chunk* Arena::allocate_chunk(size_t capacity) {
+	auto memory = ::operator new(sizeof(Chunk) + capacity);
+
+	return new (memory) Chunk { nullptr, 0, capacity };
+}
+
+void* Arena::allocate(size_t size) {
+	if (current->capacity - current->used < size) {
+		auto chunk = allocate_chunk(std::max(current->capacity * 2, size));
+		current->next = chunk;
+		current = chunk;
+	}
+
+	auto ptr = current->data() + current->used;
+	current->used += size;
+
+	return ptr;
+}
+
+Bytecode& Arena::bytecode() {
+	if (!bytecode_)
+		bytecode_ = std::make_unique<Bytecode>();
+
+	return *bytecode_;
+}
+
+NativeCode& Arena::native_code() {
+	if (!native_code_)
+		native_code_ = std::make_unique<NativeCode>();
+
+	return *native_code_;
+}
+
+// Destroys every node in parse order. As each chunk only ever contains nodes, they can be walked one after another.
+Arena::~Arena() {
+	bytecode_.reset();
+	native_code_.reset();
+
+	for (auto chunk = &first; chunk != nullptr;) {
+		for (size_t offset = 0; offset < chunk->used;) {
+			auto func = reinterpret_cast<Function*>(chunk->data() + offset);
+			offset += func->allocation_size();
+			func->~Function();
+		}
+
+		auto next = chunk->next;
+
+		if (chunk != &first)
+			::operator delete(chunk);
+
+		chunk = next;
+	}
+}
+
+void Arena::decref() noexcept {
+	RefcountStats::decref();
+
+	if (--refcount == 0) {
+		this->~Arena();
+		::operator delete(this);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ref.hpp"
+#include <cstddef>
+#include <memory>
+
+namespace kn {
+	class Function;
+	class Bytecode;
+	class NativeCode;
+
+	// The memory that backs the `Function`s of a single parsed program.
+	//
+	// Nodes, along with their arguments, are bump-allocated in parse order into a list of chunks. They're never freed
+	// individually: instead, the entire arena is dropped at once when the last `Value` referring to one of its
+	// functions goes away. (References between nodes of the same arena are not counted, so that a program doesn't
+	// keep itself alive.)
+	class Arena {
+		struct Chunk {
+			Chunk* next;
+			size_t used;
+			size_t capacity;
+
+			char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+		};
+
+		// The amount of `Value`s and `Ref<Arena>`s that refer to this arena.
+		size_t refcount;
+
+		// The chunk that allocations are currently made from; the first chunk is allocated alongside the arena itself.
+		Chunk* current;
+
+		// The bytecode compiled from this arena's functions, if they've ever been run by the virtual machine.
+		std::unique_ptr<Bytecode> bytecode_;
+
+		// The machine code compiled from this arena's loops by the `Jit`, if it's ever been enabled.
+		std::unique_ptr<NativeCode> native_code_;
+
+		Chunk first;
+
+		explicit Arena(size_t capacity) noexcept;
+		~Arena();
+
+		static Chunk* allocate_chunk(size_t capacity);
+
+	public:
+		// Creates a new arena, preallocating enough space for a program whose source is `source_length` bytes long.
+		static Ref<Arena> create(size_t source_length);
+
+		// Allocates `size` bytes, which must be a multiple of 8.
+		void* allocate(size_t size);
+
+		// Returns the bytecode for this arena's functions, creating it if needed.
+		Bytecode& bytecode();
+
+		// Returns the machine code for this arena's loops, creating it if needed.
+		NativeCode& native_code();
+
+		void incref() noexcept {
+			RefcountStats::incref();
+			++refcount;
+		}
+
+		void decref() noexcept;
+
+		// Removes a reference without ever freeing the arena; used when a reference becomes an internal one.
+		void forget_reference() noexcept { --refcount; }
+	};
+}
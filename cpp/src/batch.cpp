@@ -0,0 +1,51 @@
+#include "batch.hpp"
+#include "thread_pool.hpp"
+#include "knight.hpp"
+#include <sstream>
+
+using namespace kn;
+
+BatchResult kn::run_isolated(std::string_view source, std::istream& input,
+	std::function<void(Interpreter&)> const& configure)
+{
+	BatchResult result;
+	Interpreter interpreter(input);
+	configure(interpreter);
+
+	auto start = std::chrono::steady_clock::now();
+
+	try {
+		interpreter.run(source);
+	} catch (Quit const& quit) {
+		result.status = quit.status;
+	} catch (std::exception const& err) {
+		result.status = 1;
+		result.error = err.what();
+	}
+
+	result.elapsed = std::chrono::steady_clock::now() - start;
+	result.output = interpreter.output.take_captured();
+
+	return result;
+}
+
+std::vector<BatchResult> kn::run_batch(std::vector<std::string_view> const& sources, size_t threads,
+	std::function<void(Interpreter&)> const& configure, size_t* steals)
+{
+	std::vector<BatchResult> results(sources.size());
+	ThreadPool pool(threads);
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		pool.submit([&, i] {
+			std::istringstream input;
+			results[i] = run_isolated(sources[i], input, configure);
+		});
+	}
+
+	pool.wait();
+
+	if (steals != nullptr)
+		*steals = pool.steals();
+
+	return results;
+}
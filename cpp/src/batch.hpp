@@ -0,0 +1,40 @@
+#pragma once
+
+#include "interpreter.hpp"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace kn {
+	// How a program that was run by `run_batch` finished.
+	struct BatchResult {
+		// Zero if the program finished normally, the status it passed to `QUIT`, or one if it raised an error.
+		int status = 0;
+
+		// Everything the program wrote to its output.
+		std::string output;
+
+		// The message of the error the program raised, if any.
+		std::string error;
+
+		// How long it took to parse and run the program.
+		std::chrono::nanoseconds elapsed { 0 };
+	};
+
+	// Parses and runs `source` in a fresh interpreter that's passed to `configure` first, capturing its output.
+	//
+	// The program's `PROMPT`s read from `input`.
+	BatchResult run_isolated(std::string_view source, std::istream& input,
+		std::function<void(Interpreter&)> const& configure);
+
+	// Runs each of `sources` as an independent program, with its own interpreter, on a work-stealing pool of
+	// `threads` threads (zero uses one per hardware thread). The programs have no input.
+	//
+	// The results are in the same order as `sources`. If `steals` isn't null, the amount of programs that were run
+	// by a thread other than the one they were first given to is stored in it.
+	std::vector<BatchResult> run_batch(std::vector<std::string_view> const& sources, size_t threads,
+		std::function<void(Interpreter&)> const& configure, size_t* steals = nullptr);
+}
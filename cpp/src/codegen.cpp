@@ -0,0 +1,413 @@
+#include "codegen.hpp"
+#include "function.hpp"
+#include "precompiled.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cstdio>
+
+using namespace kn;
+
+// Returns a C++ expression for the `std::string_view` of `bytes`, which may contain anything.
+static std::string literal(std::string_view bytes) {
+	std::string out = "std::string_view(\"";
+
+	for (unsigned char byte : bytes) {
+		if (byte == '"' || byte == '\\') {
+			out += '\\';
+			out += static_cast<char>(byte);
+		} else if (' ' <= byte && byte <= '~') {
+			out += static_cast<char>(byte);
+		} else {
+			// octal escapes are at most three digits, so unlike `\x` they can't swallow the next character.
+			char escape[5];
+			std::snprintf(escape, sizeof(escape), "\\%03o", byte);
+			out += escape;
+		}
+	}
+
+	return out + "\", " + std::to_string(bytes.length()) + ")";
+}
+
+// Returns the name of the global that holds the function pointer of the builtin `name`.
+static std::string builtin(char name) {
+	switch (name) {
+	case 'P': return "PROMPT";
+	case 'R': return "RANDOM";
+	case '`': return "SYSTEM";
+	case 'Q': return "QUIT";
+	case 'L': return "LENGTH";
+	case 'D': return "DUMP";
+	case 'O': return "OUTPUT";
+	case 'G': return "GET";
+	case 'S': return "SUBSTITUTE";
+	case 'E': return "EVAL";
+	case '=': return "ASSIGN";
+	default: return "";
+	}
+}
+
+std::ostream& CodeGenerator::line() {
+	return body << std::string(depth, '\t');
+}
+
+std::string CodeGenerator::local(std::string const& initializer) {
+	auto name = "v" + std::to_string(locals++);
+	line() << "Value " << name << " = " << initializer << ";\n";
+	return name;
+}
+
+std::string CodeGenerator::leaf(Value const& value) {
+	if (value.is_variable())
+		return local("environment.run(" + std::to_string(value.as_variable()) + ")");
+
+	if (value.is_number()) {
+		if (value.as_number() == std::numeric_limits<number>::min())
+			return local("Value(std::numeric_limits<number>::min())");
+
+		return local("Value(number(" + std::to_string(value.as_number()) + "LL))");
+	}
+
+	if (value.is_boolean())
+		return local(value.to_boolean() ? "Value(true)" : "Value(false)");
+
+	if (value.is_null())
+		return local("Value()");
+
+	strings.emplace_back(value.as_string()->view());
+	return local("program.string_values[" + std::to_string(strings.size() - 1) + "]");
+}
+
+void CodeGenerator::finish(std::string const& name, std::string const& result) {
+	std::ostringstream definition;
+	definition << "static Value " << name << "(args_t) {\n"
+		"\t[[maybe_unused]] auto& environment = Interpreter::current().environment;\n"
+		"\n"
+		<< body.str()
+		<< "\treturn " << result << ";\n"
+		"}\n";
+
+	functions.push_back(definition.str());
+}
+
+void CodeGenerator::define(std::string const& name, Value const& value) {
+	// each function being generated has a frame that tracks how far along it is (`phase`), along with the locals it
+	// needs once its arguments are done; the locals holding the results of finished arguments are kept in `results`.
+	struct Frame {
+		Function const* func;
+		uint32_t phase;
+		std::string local;
+	};
+
+	// blocks are generated while in the middle of their parent, which is put aside and resumed afterwards.
+	struct Parent {
+		std::ostringstream body;
+		size_t depth;
+		size_t locals;
+	};
+
+	std::vector<Frame> frames;
+	std::vector<std::string> results;
+	std::vector<Parent> parents;
+
+	// Generates `value`: leaves are emitted immediately, whereas functions get a frame of their own. This invalidates
+	// references to the current frame, so it must be the last thing a phase does with it.
+	auto descend = [&](Value const& value) {
+		if (value.is_function())
+			frames.push_back(Frame { value.as_function(), 0, std::string() });
+		else
+			results.push_back(leaf(value));
+	};
+
+	// Removes and returns the most recent result.
+	auto pop = [&]() {
+		auto result = std::move(results.back());
+		results.pop_back();
+		return result;
+	};
+
+	descend(value);
+
+	while (!frames.empty()) {
+		auto& frame = frames.back();
+		auto& func = *frame.func;
+		auto args = func.args();
+		auto phase = frame.phase++;
+
+		if (phase == 0 && func.function() != Function::builtin(func.name()))
+			throw Error(std::string("cannot compile the non-builtin function '") + func.name() + "'");
+
+		switch (func.name()) {
+		// the lhs of `;` is only run for its side effects, so its locals are scoped to it.
+		case ';':
+			if (phase == 0) {
+				line() << "{\n";
+				++depth;
+				descend(args[0]);
+			} else if (phase == 1) {
+				pop();
+				--depth;
+				line() << "}\n";
+				descend(args[1]);
+			} else
+				goto done;
+			continue;
+
+		case '=':
+			if (!args[0].is_variable())
+				break;
+
+			if (phase == 0)
+				descend(args[1]);
+			else {
+				line() << "environment.assign(" << args[0].as_variable() << ", " << results.back() << ");\n";
+				goto done;
+			}
+			continue;
+
+		case '&':
+		case '|':
+			if (phase == 0)
+				descend(args[0]);
+			else if (phase == 1) {
+				frame.local = results.back();
+				line() << "if (" << (func.name() == '&' ? "" : "!") << "compiled::truthy(" << frame.local << ")) {\n";
+				++depth;
+				descend(args[1]);
+			} else {
+				line() << frame.local << " = std::move(" << pop() << ");\n";
+				--depth;
+				line() << "}\n";
+				goto done;
+			}
+			continue;
+
+		case 'I':
+			if (phase == 0)
+				descend(args[0]);
+			else if (phase == 1) {
+				auto condition = pop();
+				frame.local = local("Value()");
+				line() << "if (compiled::truthy(" << condition << ")) {\n";
+				++depth;
+				descend(args[1]);
+			} else if (phase == 2) {
+				line() << frame.local << " = std::move(" << pop() << ");\n";
+				--depth;
+				line() << "} else {\n";
+				++depth;
+				descend(args[2]);
+			} else {
+				line() << frame.local << " = std::move(" << pop() << ");\n";
+				--depth;
+				line() << "}\n";
+				results.push_back(std::move(frame.local));
+				goto done;
+			}
+			continue;
+
+		case 'W':
+			if (phase == 0) {
+				line() << "for (;;) {\n";
+				++depth;
+				descend(args[0]);
+			} else if (phase == 1) {
+				line() << "if (!compiled::truthy(" << pop() << "))\n";
+				line() << "\tbreak;\n";
+				descend(args[1]);
+			} else {
+				pop();
+				--depth;
+				line() << "}\n";
+				results.push_back(local("Value()"));
+				goto done;
+			}
+			continue;
+
+		case 'B':
+			if (phase == 0) {
+				frame.local = std::to_string(blocks.size());
+				blocks.push_back(Block { Precompiled::serialize(args[0]), args[0].is_function() });
+
+				if (!args[0].is_function()) {
+					results.push_back(local("program.block_values[" + frame.local + "]"));
+					goto done;
+				}
+
+				parents.push_back(Parent {
+					std::exchange(body, std::ostringstream()),
+					std::exchange(depth, 1),
+					std::exchange(locals, 0)
+				});
+				descend(args[0]);
+			} else {
+				finish("block_" + frame.local, pop());
+
+				auto& parent = parents.back();
+				body = std::move(parent.body);
+				depth = parent.depth;
+				locals = parent.locals;
+				parents.pop_back();
+
+				results.push_back(local("program.block_values[" + frame.local + "]"));
+				goto done;
+			}
+			continue;
+
+		case 'C':
+			if (phase == 0)
+				descend(args[0]);
+			else {
+				results.push_back(local("run_arg(" + pop() + ")"));
+				goto done;
+			}
+			continue;
+
+		// `DUMP` would run a block it's passed a second time, so the already-evaluated argument is dumped directly.
+		case 'D':
+			if (phase == 0)
+				descend(args[0]);
+			else {
+				results.push_back(local("compiled::dump(std::move(" + pop() + "))"));
+				goto done;
+			}
+			continue;
+
+		case '!':
+			if (phase == 0)
+				descend(args[0]);
+			else {
+				results.push_back(local("Value(!compiled::truthy(" + pop() + "))"));
+				goto done;
+			}
+			continue;
+
+		case '+': case '-': case '*': case '/': case '%': case '^': case '?': case '<': case '>':
+			if (phase < 2)
+				descend(args[phase]);
+			else {
+				auto rhs = "std::move(" + pop() + ")";
+				auto lhs = pop();
+
+				switch (func.name()) {
+				case '+': results.push_back(local("compiled::add(" + lhs + ", " + rhs + ")")); break;
+				case '-': results.push_back(local("compiled::sub(" + lhs + ", " + rhs + ")")); break;
+				case '*': results.push_back(local("compiled::mul(" + lhs + ", " + rhs + ")")); break;
+				case '/': results.push_back(local("compiled::div(" + lhs + ", " + rhs + ")")); break;
+				case '%': results.push_back(local("compiled::mod(" + lhs + ", " + rhs + ")")); break;
+				case '?': results.push_back(local("compiled::eql(" + lhs + ", " + rhs + ")")); break;
+				case '<': results.push_back(local("compiled::lth(" + lhs + ", " + rhs + ")")); break;
+				case '>': results.push_back(local("compiled::gth(" + lhs + ", " + rhs + ")")); break;
+				default: results.push_back(local(lhs + ".pow(" + rhs + ")")); break;
+				}
+
+				goto done;
+			}
+			continue;
+		}
+
+		// everything else is passed its already-evaluated arguments, which it only converts; that doesn't run them again,
+		// except for blocks, which can't be converted anyway.
+		// assigning to something that's not a variable is only here so that it raises its usual error.
+		if (phase < func.arity()) {
+			if (func.name() == '=')
+				results.push_back(local("Value()"));
+			else
+				descend(args[phase]);
+			continue;
+		}
+
+		{
+			auto name = builtin(func.name());
+
+			if (name.empty())
+				throw Error(std::string("cannot compile the function '") + func.name() + "'");
+
+			if (builtins.find(func.name()) == std::string::npos)
+				builtins += func.name();
+
+			if (func.arity() == 0) {
+				results.push_back(local(name + "(nullptr)"));
+				goto done;
+			}
+
+			std::string arguments;
+			auto first = results.end() - func.arity();
+
+			for (auto argument = first; argument != results.end(); ++argument)
+				arguments += (argument == first ? "" : ", ") + ("std::move(" + *argument + ")");
+
+			results.erase(first, results.end());
+
+			auto array = "a" + std::to_string(locals++);
+			line() << "Value " << array << "[] = { " << arguments << " };\n";
+			results.push_back(local(name + "(" + array + ")"));
+		}
+
+	done:
+		frames.pop_back();
+	}
+
+	finish(name, pop());
+}
+
+std::string CodeGenerator::generate(Value const& program) {
+	CodeGenerator generator;
+	generator.define("run", program);
+
+	// every variable was given its slot while parsing this program, so all slots up to the largest are its own.
+	slot_t slots = 0;
+	std::vector<Value const*> pending { &program };
+
+	while (!pending.empty()) {
+		auto& value = *pending.back();
+		pending.pop_back();
+
+		if (value.is_variable())
+			slots = std::max(slots, value.as_variable());
+		else if (value.is_function()) {
+			for (uint32_t i = 0; i < value.as_function()->arity(); ++i)
+				pending.push_back(&value.as_function()->args()[i]);
+		}
+	}
+
+	std::ostringstream out;
+	out << "// Generated by knightc.\n"
+		"#include \"compiled.hpp\"\n"
+		"#include <limits>\n"
+		"\n"
+		"using namespace kn;\n"
+		"\n"
+		"// leaked, so that it's never destroyed after the strings its values may refer to.\n"
+		"static CompiledProgram& program = *new CompiledProgram;\n";
+
+	for (auto name : generator.builtins)
+		out << "static funcptr_t const " << builtin(name) << " = Function::builtin('" << name << "');\n";
+
+	for (auto& function : generator.functions)
+		out << "\n" << function;
+
+	out << "\n"
+		"int main() {\n";
+
+	for (slot_t slot = 1; slot <= slots; ++slot)
+		out << "\tprogram.variables.push_back(" << literal(Variable::name(slot)) << ");\n";
+
+	for (auto& string : generator.strings)
+		out << "\tprogram.strings.push_back(" << literal(string) << ");\n";
+
+	for (size_t i = 0; i < generator.blocks.size(); ++i) {
+		auto& block = generator.blocks[i];
+
+		out << "\tprogram.blocks.push_back({ " << literal(block.body) << ", "
+			<< (block.compiled ? "&block_" + std::to_string(i) : std::string("nullptr")) << " });\n";
+	}
+
+	out << "\tprogram.run = &run;\n"
+		"\n"
+		"\treturn run_compiled(program);\n"
+		"}\n";
+
+	return out.str();
+}
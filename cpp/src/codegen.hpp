@@ -0,0 +1,74 @@
+#pragma once
+
+#include "value.hpp"
+#include <string>
+#include <vector>
+#include <sstream>
+
+namespace kn {
+	// Translates parsed programs into standalone C++ translation units, which is what `knightc` emits.
+	//
+	// The generated code calls `Value`'s operations and the builtins directly, with `IF`, `WHILE`, `&`, `|`, and `;`
+	// lowered to native control flow and every intermediate result held in a local. Variables keep the slots they were
+	// given when the program was parsed, which the generated program recreates by looking their names up in the same
+	// order before it starts (see `CompiledProgram`).
+	//
+	// The bodies of `BLOCK`s are compiled into functions of their own, but are also embedded precompiled, so that blocks
+	// are still real functions that `DUMP`, `EVAL`ed code, and everything else can use; once deserialized, each body's
+	// function is replaced with its compiled code. Source given to `EVAL` is run by the tree-walking interpreter.
+	//
+	// The unit includes `compiled.hpp`, and must be linked against the rest of the interpreter (`libknight.a`).
+	class CodeGenerator {
+		// The statements of the function being generated.
+		std::ostringstream body;
+
+		// How deeply the next statement is nested, and the amount of locals that have been declared.
+		size_t depth = 1;
+		size_t locals = 0;
+
+		// The definitions of the functions that have been generated so far.
+		std::vector<std::string> functions;
+
+		struct Block {
+			// The block's body, encoded by `Precompiled`.
+			std::string body;
+
+			// Whether the body was compiled into a function named `block_<index>`.
+			bool compiled;
+		};
+
+		// The program's string literals and blocks.
+		std::vector<std::string> strings;
+		std::vector<Block> blocks;
+
+		// The names of the builtins that are called through their function pointers.
+		std::string builtins;
+
+		// Starts a new statement.
+		std::ostream& line();
+
+		// Declares a new local initialized by `initializer`, returning its name.
+		std::string local(std::string const& initializer);
+
+		// Declares a local holding `value`, which mustn't be a function, returning its name.
+		std::string leaf(Value const& value);
+
+		// Adds the definition of the function called `name`, made of the statements in `body`, which returns `result`.
+		void finish(std::string const& name, std::string const& result);
+
+		// Generates a function called `name` which evaluates `value`.
+		//
+		// Like parsing, this uses an explicit stack rather than recursing into arguments (or the bodies of blocks), so
+		// how deeply programs can nest is only limited by memory.
+		void define(std::string const& name, Value const& value);
+
+		CodeGenerator() = default;
+
+	public:
+		// Returns the C++ translation unit for `program`, which must have been parsed by the current interpreter (and
+		// not optimized, as fused and quickened functions can't be translated).
+		//
+		// Throws an `Error` if `program` contains a function that isn't a builtin.
+		static std::string generate(Value const& program);
+	};
+}
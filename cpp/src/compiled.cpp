@@ -0,0 +1,48 @@
+#include "compiled.hpp"
+#include "interpreter.hpp"
+#include "precompiled.hpp"
+#include <iostream>
+#include <unistd.h>
+
+using namespace kn;
+
+int kn::run_compiled(CompiledProgram& program) {
+	Interpreter interpreter(std::cin, STDOUT_FILENO);
+	Interpreter::Scope scope(interpreter);
+
+	int status = 0;
+
+	try {
+		// a new environment hands out slots in order, so this gives each variable the slot the program refers to it by.
+		for (auto name : program.variables)
+			interpreter.environment.lookup(name);
+
+		for (auto string : program.strings)
+			program.string_values.emplace_back(String::create(string));
+
+		for (auto block : program.blocks) {
+			auto body = Precompiled::deserialize(block.body);
+
+			if (block.compiled != nullptr)
+				body.as_function()->set_function(block.compiled);
+
+			program.block_values.push_back(std::move(body));
+		}
+
+		program.run(nullptr);
+	} catch (Quit const& quit) {
+		status = quit.status;
+	} catch (std::exception& err) {
+		interpreter.output.flush();
+		std::cerr << "error with your code: " << err.what() << std::endl;
+		status = 1;
+	}
+
+	interpreter.output.flush();
+
+	// the values belong to this run, so they're released while the interpreter they were created for still exists.
+	program.string_values.clear();
+	program.block_values.clear();
+
+	return status;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "value.hpp"
+#include "function.hpp"
+#include "interpreter.hpp"
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace kn {
+	// A program that `knightc` has translated into C++ (see `CodeGenerator`).
+	struct CompiledProgram {
+		struct Block {
+			// The block's body, encoded by `Precompiled`.
+			std::string_view body;
+
+			// The compiled code of the body, which replaces its function; null if the body isn't a function.
+			funcptr_t compiled;
+		};
+
+		// The names of the program's variables, in the order of their slots (starting at slot one).
+		std::vector<std::string_view> variables;
+
+		// The program's string literals and blocks.
+		std::vector<std::string_view> strings;
+		std::vector<Block> blocks;
+
+		// The program itself, which ignores its arguments.
+		funcptr_t run = nullptr;
+
+		// The values of `strings` and `blocks`, which are created by `run_compiled` before `run` is called, and
+		// released before it returns.
+		std::vector<Value> string_values;
+		std::vector<Value> block_values;
+	};
+
+	// Runs `program` with a new interpreter, like `knight -e` would; returns the status to exit with.
+	int run_compiled(CompiledProgram& program);
+
+	// The operators that compiled programs use, which handle numbers inline before falling back to `Value`'s.
+	namespace compiled {
+		inline Value add(Value& lhs, Value&& rhs) {
+			return lhs.is_number() && rhs.is_number() ? Value(lhs.as_number() + rhs.as_number()) : lhs + std::move(rhs);
+		}
+
+		inline Value sub(Value& lhs, Value&& rhs) {
+			return lhs.is_number() && rhs.is_number() ? Value(lhs.as_number() - rhs.as_number()) : lhs - std::move(rhs);
+		}
+
+		inline Value mul(Value& lhs, Value&& rhs) {
+			return lhs.is_number() && rhs.is_number() ? Value(lhs.as_number() * rhs.as_number()) : lhs * std::move(rhs);
+		}
+
+		// dividing by zero goes through `Value`, so it raises the same error.
+		inline Value div(Value& lhs, Value&& rhs) {
+			if (lhs.is_number() && rhs.is_number() && rhs.as_number() != 0)
+				return Value(lhs.as_number() / rhs.as_number());
+
+			return lhs / std::move(rhs);
+		}
+
+		inline Value mod(Value& lhs, Value&& rhs) {
+			if (lhs.is_number() && rhs.is_number() && rhs.as_number() != 0)
+				return Value(lhs.as_number() % rhs.as_number());
+
+			return lhs % std::move(rhs);
+		}
+
+		inline Value eql(Value& lhs, Value&& rhs) {
+			return Value(lhs.is_number() && rhs.is_number() ? lhs.as_number() == rhs.as_number() : lhs == std::move(rhs));
+		}
+
+		inline Value lth(Value& lhs, Value&& rhs) {
+			return Value(lhs.is_number() && rhs.is_number() ? lhs.as_number() < rhs.as_number() : lhs < std::move(rhs));
+		}
+
+		inline Value gth(Value& lhs, Value&& rhs) {
+			return Value(lhs.is_number() && rhs.is_number() ? lhs.as_number() > rhs.as_number() : lhs > std::move(rhs));
+		}
+
+		inline bool truthy(Value& value) {
+			return value.is_number() ? value.as_number() != 0 : value.to_boolean();
+		}
+
+		// `DUMP`, for an argument that's already been evaluated.
+		inline Value dump(Value&& value) {
+			std::ostringstream out;
+			value.dump(out) << '\n';
+			Interpreter::current().output.write(out.str());
+			return std::move(value);
+		}
+	}
+}
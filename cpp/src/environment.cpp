@@ -0,0 +1,19 @@
+#include "environment.hpp"
+
+using namespace kn;
+
+slot_t Environment::lookup(std::string_view name) {
+	if (auto match = slots.find(name); match != slots.cend())
+		return match->second;
+
+	auto slot = static_cast<slot_t>(values.size());
+	values.push_back(Value::undefined());
+	names.emplace_back(name);
+	slots.emplace(std::string_view(names.back()), slot);
+
+	return slot;
+}
+
+void Environment::unassigned(slot_t slot) const {
+	throw Error("unknown variable encountered: " + names[slot]);
+}
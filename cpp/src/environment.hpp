@@ -0,0 +1,71 @@
+#pragma once
+
+#include "value.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+namespace kn {
+	// The variables of a single `Interpreter`.
+	//
+	// As per the Knight specs, all variables are global. Each distinct identifier is given a dense slot the first time
+	// it's parsed, and the values of all variables live in one contiguous array indexed by those slots. Parsed
+	// programs refer to variables by slot, so reading or assigning one is a single index; the name-to-slot index is
+	// only consulted while parsing.
+	//
+	// As slots are only meaningful to the environment that handed them out, programs must be run by the same
+	// interpreter that parsed them.
+	class Environment {
+		// The value of each slot; unassigned variables hold an undefined value.
+		//
+		// Slot zero is never used, so that a variable `Value` is never all zero bits (ie `NULL`).
+		std::vector<Value> values { Value::undefined() };
+
+		// The name of each slot. This is a `deque` so that names never move, as `slots` refers to them.
+		std::deque<std::string> names { std::string() };
+
+		// Maps the name of each known variable to its slot.
+		std::unordered_map<std::string_view, slot_t> slots;
+
+		// Throws the error for reading the unassigned variable at `slot`.
+		[[noreturn]] void unassigned(slot_t slot) const;
+
+	public:
+		Environment() = default;
+		Environment(Environment const&) = delete;
+		Environment& operator=(Environment const&) = delete;
+
+		// Returns the slot of the variable called `name`, giving it a new one if it's never been seen before.
+		//
+		// This invalidates `data()`, if a new slot is given out.
+		slot_t lookup(std::string_view name);
+
+		// The values of all slots, indexed by slot; native code reads and writes numbers in place through this.
+		Value* data() noexcept { return values.data(); }
+
+		// Returns the name of the variable at `slot`.
+		std::string_view name(slot_t slot) const noexcept { return names[slot]; }
+
+		// Looks up the value last assigned to the variable at `slot`.
+		//
+		// Throws an `Error` if the variable was never assigned.
+		Value run(slot_t slot) const { return borrow(slot); }
+
+		// Like `run`, but returns the value in place, which is only valid until the variable is next assigned.
+		Value const& borrow(slot_t slot) const {
+			auto& value = values[slot];
+
+			if (value.is_undefined())
+				unassigned(slot);
+
+			return value;
+		}
+
+		// Assigns a value to the variable at `slot`, discarding its previous value.
+		void assign(slot_t slot, Value value) noexcept {
+			values[slot] = std::move(value);
+		}
+	};
+}
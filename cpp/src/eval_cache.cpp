@@ -0,0 +1,51 @@
+#include "eval_cache.hpp"
+#include "interpreter.hpp"
+
+using namespace kn;
+
+Value EvalCache::lookup(std::string_view source) {
+	if (auto match = index.find(source); match != index.cend()) {
+		++hits_;
+		entries.splice(entries.begin(), entries, match->second);
+		return match->second->program;
+	}
+
+	++misses_;
+
+	auto view = source;
+	auto program = Value::parse(view);
+
+	if (!program)
+		throw Error("cannot parse a value");
+
+	Interpreter::current().optimize(*program);
+
+	if (capacity_ == 0)
+		return std::move(*program);
+
+	if (entries.size() == capacity_) {
+		index.erase(entries.back().source);
+		entries.pop_back();
+		++evictions_;
+	}
+
+	entries.push_front(Entry { std::string(source), std::move(*program) });
+	index.emplace(entries.front().source, entries.begin());
+
+	return entries.front().program;
+}
+
+void EvalCache::set_capacity(size_t capacity) {
+	capacity_ = capacity;
+
+	while (capacity_ < entries.size()) {
+		index.erase(entries.back().source);
+		entries.pop_back();
+		++evictions_;
+	}
+}
+
+std::ostream& EvalCache::dump_stats(std::ostream& out) const {
+	return out << "eval cache: " << hits_ << " hits, " << misses_ << " misses, " << evictions_ << " evictions, "
+		<< entries.size() << "/" << capacity_ << " entries" << std::endl;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "value.hpp"
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <ostream>
+#include <cstddef>
+
+namespace kn {
+	// A bounded cache from source code to its parsed `Value`, used by `EVAL` so that evaluating the same string again
+	// only costs a hash lookup, rather than a full parse.
+	//
+	// Programs are optimized before they're cached. When the cache is full, the least recently used program is evicted.
+	class EvalCache {
+		struct Entry {
+			std::string source;
+			Value program;
+		};
+
+		// The cached programs, from most to least recently used.
+		std::list<Entry> entries;
+
+		// Maps the source of each entry (which it owns) to its position within `entries`.
+		std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+
+		// The maximum amount of programs that are cached; zero disables the cache entirely.
+		size_t capacity_;
+
+		size_t hits_ = 0;
+		size_t misses_ = 0;
+		size_t evictions_ = 0;
+
+	public:
+		// The default amount of programs that are cached.
+		static constexpr size_t DEFAULT_CAPACITY = 256;
+
+		explicit EvalCache(size_t capacity = DEFAULT_CAPACITY) noexcept : capacity_(capacity) {}
+
+		// Returns the parsed program for `source`, parsing and caching it if it isn't already.
+		//
+		// Throws an `Error` if `source` doesn't contain a value.
+		Value lookup(std::string_view source);
+
+		// Changes the maximum amount of programs that are cached, evicting any in excess of it.
+		void set_capacity(size_t capacity);
+		size_t capacity() const noexcept { return capacity_; }
+
+		size_t hits() const noexcept { return hits_; }
+		size_t misses() const noexcept { return misses_; }
+		size_t evictions() const noexcept { return evictions_; }
+
+		// Writes the cache's counters to `out`.
+		std::ostream& dump_stats(std::ostream& out) const;
+	};
+}
@@ -0,0 +1,120 @@
+#include "fold.hpp"
+#include "function.hpp"
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+using namespace kn;
+
+// Whether the builtin `name` always returns the same result for the same literal arguments, without side effects.
+//
+// `BLOCK` is deliberately excluded, as its result is the unevaluated node itself, and `WHILE` is excluded as a literal
+// truthy condition would never finish.
+static bool is_pure(char name) noexcept {
+	switch (name) {
+	case '+': case '-': case '*': case '/': case '%': case '^':
+	case '?': case '<': case '>': case '!': case '&': case '|':
+	case ';': case 'I': case 'L': case 'G': case 'S':
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+// The largest power, and longest string repetition, that's folded. Anything bigger is only computed if it's actually
+// run, as it could take arbitrarily long (or run out of memory), even in a branch that never is.
+static constexpr number MAX_FOLDED_EXPONENT = 64;
+static constexpr number MAX_FOLDED_LENGTH = 4096;
+
+// Whether evaluating `func`, whose arguments are all literals, is cheap enough to do while folding.
+static bool is_bounded(Function& func) {
+	auto args = func.args();
+
+	switch (func.name()) {
+	case '^':
+		return args[0].is_number() && args[1].to_number() < MAX_FOLDED_EXPONENT;
+
+	case '*':
+		if (!args[0].is_string())
+			return true;
+
+		return args[1].to_number() <= MAX_FOLDED_LENGTH / std::max<number>(1, args[0].as_string()->length());
+
+	default:
+		return true;
+	}
+}
+
+// Whether `value` always evaluates to itself.
+static bool is_literal(Value const& value) noexcept {
+	return !value.is_function() && !value.is_variable();
+}
+
+// Returns the result of `func` if it can be folded, ie it's pure, all of its arguments are literals, it's cheap to
+// evaluate, and it runs without raising an error.
+static std::optional<Value> evaluate(Function& func) {
+	if (!is_pure(func.name()))
+		return std::nullopt;
+
+	for (uint32_t i = 0; i < func.arity(); ++i) {
+		if (!is_literal(func.args()[i]))
+			return std::nullopt;
+	}
+
+	if (!is_bounded(func))
+		return std::nullopt;
+
+	try {
+		return func.run();
+	} catch (std::exception const&) {
+		return std::nullopt;
+	}
+}
+
+void ConstantFolder::fold_value(Value& value) {
+	if (!value.is_function())
+		return;
+
+	// functions are visited after their arguments, with an explicit stack so that deep programs can't overflow.
+	struct Frame {
+		Function* func;
+		uint32_t next;
+	};
+
+	std::vector<Frame> frames { Frame { value.as_function(), 0 } };
+
+	while (!frames.empty()) {
+		auto& frame = frames.back();
+		auto func = frame.func;
+
+		// a block's body is left as it was written, as `DUMP` shows the body of a block that's passed to it.
+		if (frame.next < func->arity() && func->name() != 'B') {
+			auto& arg = func->args()[frame.next++];
+
+			if (arg.is_function())
+				frames.push_back(Frame { arg.as_function(), 0 });
+
+			continue;
+		}
+
+		frames.pop_back();
+
+		auto result = evaluate(*func);
+
+		if (!result)
+			continue;
+
+		++folded_;
+
+		// the folded function is left in its arena, which destroys it along with everything else.
+		if (frames.empty())
+			value = std::move(*result);
+		else
+			frames.back().func->replace_arg(frames.back().next - 1, std::move(*result));
+	}
+}
+
+std::ostream& ConstantFolder::dump_stats(std::ostream& out) const {
+	return out << "constant folding: " << folded_ << " nodes folded" << std::endl;
+}
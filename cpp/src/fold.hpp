@@ -0,0 +1,42 @@
+#pragma once
+
+#include "value.hpp"
+#include <ostream>
+#include <cstddef>
+
+namespace kn {
+	// An optimization pass that's run on programs after they're parsed, which replaces subtrees made only of literals
+	// with the value they evaluate to, so that they aren't reevaluated every time they're run.
+	//
+	// Only functions without side effects are folded; anything involving variables, `PROMPT`, `RANDOM`, `` ` ``, or
+	// `EVAL` is left alone. Subtrees whose evaluation raises an error are also left alone, so that the error is
+	// still raised when (and if) they're actually run. Nothing within a `BLOCK` is folded either, so that `DUMP`
+	// shows blocks the same with or without the pass.
+	class ConstantFolder {
+		// Whether the pass is run at all; it's off by default.
+		bool enabled_ = false;
+
+		// The total amount of function nodes that have been replaced by constants.
+		size_t folded_ = 0;
+
+		// Folds the subtrees of `value`, then `value` itself if it's now made only of literals.
+		//
+		// Like parsing, this uses an explicit stack rather than recursion.
+		void fold_value(Value& value);
+
+	public:
+		void enable(bool enabled = true) noexcept { enabled_ = enabled; }
+		bool enabled() const noexcept { return enabled_; }
+
+		size_t folded() const noexcept { return folded_; }
+
+		// Folds the constant subtrees of `program` in place, if the pass is enabled.
+		void fold(Value& program) {
+			if (enabled_)
+				fold_value(program);
+		}
+
+		// Writes the amount of folded nodes to `out`.
+		std::ostream& dump_stats(std::ostream& out) const;
+	};
+}
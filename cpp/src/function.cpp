@@ -2,104 +2,133 @@
 #include "value.hpp"
 #include "variable.hpp"
 #include "knight.hpp"
-#include "robin_hood_map.hpp"
+#include "interpreter.hpp"
+#include "lexer.hpp"
 
 #include <iostream>
+#include <sstream>
 #include <cstdio>
+#include <memory>
+#include <array>
 
 using namespace kn;
 
-// The list of all _functions_
-static robin_hood::unordered_map<char, std::pair<funcptr_t, size_t>> FUNCTIONS;
+Function::Function(Arena& arena, funcptr_t func, char name, uint32_t arity) noexcept
+	: arena_(arena), func_(func), name_(name), arity_(arity)
+{
+	std::uninitialized_fill_n(args(), arity_, Value());
+}
+
+Function::~Function() {
+	for (uint32_t i = 0; i < arity_; ++i) {
+		// arguments within the same arena don't own a reference to it.
+		if (args()[i].is_function())
+			args()[i].forget();
+
+		args()[i].~Value();
+	}
+}
 
-Function::Function(funcptr_t func, char name, args_t args) : func(func), name(name), args(args) { }
+void Function::set_arg(size_t index, Value value) noexcept {
+	if (value.is_function())
+		arena_.forget_reference();
 
-Value Function::run() {
-	return func(args);
+	args()[index] = std::move(value);
 }
 
-std::optional<Value> Function::parse(std::string_view& view) {
+void Function::replace_arg(size_t index, Value value) noexcept {
+	// the old argument doesn't own a reference to the arena if it's a function, so it mustn't be released.
+	if (args()[index].is_function())
+		args()[index].forget();
+
+	set_arg(index, std::move(value));
+}
+
+std::optional<Value> Function::parse(std::string_view& view, Arena& arena) {
 	char front = view.front();
+	auto func = create(front, arena);
 
 	// if the first character isn't a valid function Variable, then just return early.
-	if (FUNCTIONS.count(front) == 0)
+	if (!func)
 		return std::nullopt;
 
 	view.remove_prefix(1);
 
-	auto func_pair = FUNCTIONS[front];
-
 	// remove trailing upper-case letters for keyword functions.
-	if (isupper(front)) {
-		while (isupper(view.front()) || view.front() == '_')
-			view.remove_prefix(1);
-	}
+	if (lexer::is(front, lexer::KEYWORD))
+		view.remove_prefix(lexer::span(view, lexer::KEYWORD));
 
-	// parse the arguments out.
-	args_t args;
-	for(size_t i = 0; i < func_pair.second; ++i) {
-		if (auto value = Value::parse(view))
-			args.push_back(*value);
-		else
-			throw Error("Cannot parse function.");
-	}
-
-	return std::make_optional<Value>(std::make_shared<Function>(Function(func_pair.first, front, args)));
+	return func;
 }
 
-
 std::ostream& Function::dump(std::ostream& out) const {
-	out << "Function(" << name;
+	out << "Function(" << name_;
 
-	for (auto arg : args) {
+	for (uint32_t i = 0; i < arity_; ++i) {
 		out << ", ";
-		arg.dump(out);
+		args()[i].dump(out);
 	}
 
 	return out << ")";
 }
 
-void Function::register_function(char name, size_t arity, funcptr_t func) {
-	FUNCTIONS.insert({ name, std::make_pair(func, arity) });
-}
-
-// Prompts for a single line from stdin.
-static Value prompt(args_t& args) {
+// Prompts for a single line from the interpreter's input.
+static Value prompt(args_t args) {
 	(void) args;
+	auto& interpreter = Interpreter::current();
+
+	// make sure anything that's been written is visible before waiting on the user.
+	interpreter.output.flush();
 
-	string line;
-	std::getline(std::cin, line);
+	std::string line;
+	std::getline(interpreter.input, line);
 
-	return Value(line);
+	return Value(String::create(line));
 }
 
 // Gets a random number.
-static Value random(args_t& args) {
+static Value random(args_t args) {
 	(void) args;
 
-	return Value((number) rand());
+	// the generator's output is 32 bits; dropping one keeps it within `rand`'s usual range.
+	return Value((number) (Interpreter::current().random() >> 1));
 }
 
 // Creates a block of code.
-static Value block(args_t& args) {
+static Value block(args_t args) {
 	return args[0];
 }
 
 // Calls a block of code.
-static Value call(args_t& args) {
-	return args[0].run().run();
+static Value call(args_t args) {
+	Value scratch;
+
+	return run_arg(borrow_arg(args[0], scratch));
 }
 
 // Evaluates the argument as Knight source code.
-static Value eval(args_t& args) {
-	return kn::run(*args[0].to_string());
+//
+// Programs are looked up in the interpreter's `eval_cache` first, so repeatedly evaluating the same source doesn't reparse it.
+static Value eval(args_t args) {
+	// keep our own reference to the program, as running it may evict it from the cache.
+	char buffer[MAX_NUMBER_LENGTH];
+	Value scratch;
+	auto program = Interpreter::current().eval_cache.lookup(args[0].to_string_view(buffer, scratch));
+
+	return kn::execute(program);
 }
 
 // Runs a shell command, returns the stdout of the command.
 // effectively copied my C impl...
-static Value system(args_t& args) {
-	auto cmd = args[0].to_string();
-	FILE *stream = popen(cmd->c_str(), "r");
+static Value system(args_t args) {
+	char buffer[MAX_NUMBER_LENGTH];
+	Value scratch;
+	auto cmd = args[0].to_string_view(buffer, scratch);
+
+	// the command may write to the same stdout, so our output has to come first.
+	Interpreter::current().output.flush();
+
+	FILE *stream = popen(std::string(cmd).c_str(), "r");
 
 	if (stream == NULL) {
 		throw Error("unable to execute command.");
@@ -134,29 +163,41 @@ static Value system(args_t& args) {
 		throw Error("unable to close command stream.");
 	}
 
-	return Value(string(result));
+	auto ret = String::create(std::string_view(result, length));
+	free(result);
+
+	return Value(std::move(ret));
 }
 
 // Stops the program with the given status code.
-static Value quit(args_t& args) {
-	exit(args[0].to_number());
+//
+// Only the program is stopped, not the process: the interpreter's caller decides what to do with the status.
+static Value quit(args_t args) {
+	auto status = args[0].to_number();
+
+	Interpreter::current().output.flush();
+	throw Quit { static_cast<int>(status) };
 }
 
 // Logical negation of its argument.
-static Value not_(args_t& args) {
+static Value not_(args_t args) {
 	return Value((bool) !args[0].to_boolean());
 }
 
 // Returns the length of the argument, when converted to a string.
-static Value length(args_t& args) {
-	return Value((number) args[0].to_string()->length());
+//
+// Numbers have their digits counted, rather than being converted.
+static Value length(args_t args) {
+	return Value((number) args[0].string_length());
 }
 
-// Returns the length of the argument, when converted to a string.
-static Value dump(args_t& args) {
-	auto arg = args[0].run();
+// Writes debugging information about the argument to the output, and then returns it.
+static Value dump(args_t args) {
+	auto arg = run_arg(args[0]);
 
-	arg.dump(std::cout) << std::endl;
+	std::ostringstream out;
+	arg.dump(out) << '\n';
+	Interpreter::current().output.write(out.str());
 
 	return arg;
 }
@@ -164,96 +205,240 @@ static Value dump(args_t& args) {
 // Runs the value, then converts it to a string and prints it. The execution result is returned.
 //
 // If the string ends with a backslash, its removed before printing. Otherwise, a newline is added.
-static Value output(args_t& args) {
-	auto str = args[0].to_string();
-
-	if (!str->empty() && str->back() == '\\') {
-		str->pop_back(); // delete the trailing newline
-
-		std::cout << str;
-		str->push_back('\\'); // add it back
+static Value output(args_t args) {
+	char buffer[MAX_NUMBER_LENGTH];
+	Value scratch;
+	auto str = args[0].to_string_view(buffer, scratch);
+	auto& output = Interpreter::current().output;
+
+	if (!str.empty() && str.back() == '\\') {
+		str.remove_suffix(1); // delete the trailing backslash
+		output.write(str);
 	} else {
-		std::cout << str << std::endl;
+		output.write(str);
+		output.write("\n");
 	}
 
 	return Value();
 }
 
-// Adds two values together.
-static Value add(args_t& args) {
-	return args[0].run() + args[1].run();
+// The binary builtins below specialize themselves ("quicken") on the kinds of operands they see.
+//
+// A node starts out running `quicken`, which records the kinds of its first operands in its feedback and rewrites
+// itself to the version for them: `numbers` if they were both numbers, `strings` if they were both strings (for the
+// builtins with a faster way of handling them), and `generic` otherwise. The specialized versions check their operands
+// each time, and permanently fall back to `generic` the first time they see something else.
+//
+// Operands are borrowed rather than copied (see `borrow_arg`), except for a variable on the left when the right is a
+// function, as running it could reassign the variable (see `hold_arg`).
+//
+// Each builtin is a struct describing how it handles a pair of numbers, a pair of strings, and anything else.
+namespace {
+	// The kinds of operands a node has seen, which are recorded in its feedback.
+	enum Seen : uint8_t {
+		SEEN_NUMBERS = 1,
+		SEEN_STRINGS = 2,
+		SEEN_OTHER = 4
+	};
+
+	// Adds two values together.
+	struct Add {
+		static constexpr bool HAS_STRINGS = true;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return lhs + rhs; }
+		static Value numbers(number lhs, number rhs) { return Value(lhs + rhs); }
+
+		static Value strings(String& lhs, String& rhs) {
+			return Value(String::concat(Ref<String>::share(lhs), Ref<String>::share(rhs)));
+		}
+	};
+
+	// Subtracts the second value from the first.
+	struct Sub {
+		static constexpr bool HAS_STRINGS = false;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return lhs - rhs; }
+		static Value numbers(number lhs, number rhs) { return Value(lhs - rhs); }
+		static Value strings(String&, String&);
+	};
+
+	// Multiplies the two values together.
+	struct Mul {
+		static constexpr bool HAS_STRINGS = false;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return lhs * rhs; }
+		static Value numbers(number lhs, number rhs) { return Value(lhs * rhs); }
+		static Value strings(String&, String&);
+	};
+
+	// Divides the first value by the second.
+	struct Div {
+		static constexpr bool HAS_STRINGS = false;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return lhs / rhs; }
+
+		// dividing by zero goes through the generic path, so it raises the same error.
+		static Value numbers(number lhs, number rhs) { return rhs ? Value(lhs / rhs) : generic(Value(lhs), Value(rhs)); }
+		static Value strings(String&, String&);
+	};
+
+	// Modulos the first value by the second.
+	struct Mod {
+		static constexpr bool HAS_STRINGS = false;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return lhs % rhs; }
+		static Value numbers(number lhs, number rhs) { return rhs ? Value(lhs % rhs) : generic(Value(lhs), Value(rhs)); }
+		static Value strings(String&, String&);
+	};
+
+	// Checks to see if the two values are equal.
+	struct Eql {
+		static constexpr bool HAS_STRINGS = true;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return Value(lhs == rhs); }
+		static Value numbers(number lhs, number rhs) { return Value(lhs == rhs); }
+		static Value strings(String& lhs, String& rhs) { return Value(lhs.view() == rhs.view()); }
+	};
+
+	// Checks to see if the first value is less than the second.
+	struct Lth {
+		static constexpr bool HAS_STRINGS = true;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return Value(lhs < rhs); }
+		static Value numbers(number lhs, number rhs) { return Value(lhs < rhs); }
+		static Value strings(String& lhs, String& rhs) { return Value(lhs.view() < rhs.view()); }
+	};
+
+	// Checks to see if the first value is greater than the second.
+	struct Gth {
+		static constexpr bool HAS_STRINGS = true;
+
+		static Value generic(Value const& lhs, Value const& rhs) { return Value(lhs > rhs); }
+		static Value numbers(number lhs, number rhs) { return Value(lhs > rhs); }
+		static Value strings(String& lhs, String& rhs) { return Value(lhs.view() > rhs.view()); }
+	};
 }
 
-// Subtracts the second value from the first.
-static Value sub(args_t& args) {
-	return args[0].run() - args[1].run();
+// Returns the kinds of `lhs` and `rhs` as a pair.
+static Seen seen(Value const& lhs, Value const& rhs) noexcept {
+	if (lhs.is_number() && rhs.is_number())
+		return SEEN_NUMBERS;
+
+	if (lhs.is_string() && rhs.is_string())
+		return SEEN_STRINGS;
+
+	return SEEN_OTHER;
 }
 
-// Multiplies the two values together.
-static Value mul(args_t& args) {
-	return args[0].run() * args[1].run();
+template<typename Op>
+static Value generic(args_t args) {
+	Value lscratch, rscratch;
+	auto& lhs = hold_arg(args[0], args[1], lscratch);
+
+	return Op::generic(lhs, borrow_arg(args[1], rscratch));
 }
-// Divides the first value by the second.
-static Value div(args_t& args) {
-	return args[0].run() / args[1].run();
+
+// Permanently rewrites the node of `args` to the generic version of `Op`, now that it's `also` seen other operands.
+template<typename Op>
+static void deoptimize(args_t args, Seen also) noexcept {
+	auto& node = Function::from_args(args);
+
+	node.set_feedback(node.feedback() | also);
+	node.set_function(&generic<Op>);
 }
 
-// Modulos the first value by the second.
-static Value mod(args_t& args) {
-	return args[0].run() % args[1].run();
+template<typename Op>
+static Value numbers(args_t args) {
+	Value lscratch, rscratch;
+	auto& lhs = hold_arg(args[0], args[1], lscratch);
+	auto& rhs = borrow_arg(args[1], rscratch);
+
+	if (lhs.is_number() && rhs.is_number())
+		return Op::numbers(lhs.as_number(), rhs.as_number());
+
+	deoptimize<Op>(args, seen(lhs, rhs));
+	return Op::generic(lhs, rhs);
 }
 
-// Raises the first value to the power of the second.
-static Value pow(args_t& args) {
-	return args[0].run().pow(args[1].run());
+template<typename Op>
+static Value strings(args_t args) {
+	Value lscratch, rscratch;
+	auto& lhs = hold_arg(args[0], args[1], lscratch);
+	auto& rhs = borrow_arg(args[1], rscratch);
+
+	if (lhs.is_string() && rhs.is_string())
+		return Op::strings(*lhs.as_string(), *rhs.as_string());
+
+	deoptimize<Op>(args, seen(lhs, rhs));
+	return Op::generic(lhs, rhs);
 }
 
-// Checks to see if the two values are equal.
-static Value eql(args_t& args) {
-	return Value(args[0].run() == args[1].run());
-}	
+// What every node of `Op` initially runs.
+template<typename Op>
+static Value quicken(args_t args) {
+	Value lscratch, rscratch;
+	auto& lhs = hold_arg(args[0], args[1], lscratch);
+	auto& rhs = borrow_arg(args[1], rscratch);
+	auto kinds = seen(lhs, rhs);
+	auto& node = Function::from_args(args);
 
-// Checks to see if the first value is less than the second.
-static Value lth(args_t& args) {
-	return Value(args[0].run() < args[1].run());
+	node.set_feedback(kinds);
+
+	if (kinds == SEEN_NUMBERS) {
+		node.set_function(&numbers<Op>);
+		return Op::numbers(lhs.as_number(), rhs.as_number());
+	}
+
+	if constexpr (Op::HAS_STRINGS) {
+		if (kinds == SEEN_STRINGS) {
+			node.set_function(&strings<Op>);
+			return Op::strings(*lhs.as_string(), *rhs.as_string());
+		}
+	}
+
+	node.set_function(&generic<Op>);
+	return Op::generic(lhs, rhs);
 }
 
-// Checks to see if the first value is greater than the second.
-static Value gth(args_t& args) {
-	return Value(args[0].run() > args[1].run());
+// Raises the first value to the power of the second.
+static Value pow(args_t args) {
+	Value lscratch, rscratch;
+	auto& lhs = hold_arg(args[0], args[1], lscratch);
+
+	return lhs.pow(borrow_arg(args[1], rscratch));
 }
 
 // Evaluates the first value, returning it if it's falsey. Otherwise evaluates and returns the second.
-static Value and_(args_t& args) {
-	auto lhs = args[0].run();
+static Value and_(args_t args) {
+	Value scratch;
+	auto& lhs = borrow_arg(args[0], scratch);
 
-	return lhs.to_boolean() ? args[1].run() : lhs;
+	return lhs.to_boolean() ? run_arg(args[1]) : lhs;
 }
 
 // Evaluates the first value, returning it if it's truthy. Otherwise evaluates and returns the second.
-static Value or_(args_t& args) {
-	auto lhs = args[0].run();
+static Value or_(args_t args) {
+	Value scratch;
+	auto& lhs = borrow_arg(args[0], scratch);
 
-	return lhs.to_boolean() ? lhs : args[1].run();
+	return lhs.to_boolean() ? lhs : run_arg(args[1]);
 }
 
 // Runs the first value, then runs the second and returns it.
-static Value then(args_t& args) {
-	args[0].run();
+static Value then(args_t args) {
+	run_arg(args[0]);
 
-	return args[1].run();
+	return run_arg(args[1]);
 }
 
 // Assigns the second value to the first.
-static Value assign(args_t& args) {
-	auto variable = args[0].as_variable();
-
-	if (variable == nullptr)
+static Value assign(args_t args) {
+	if (!args[0].is_variable())
 		throw Error("cannot assign to non-variables");
 
-	auto value = args[1].run();
+	auto value = run_arg(args[1]);
 
-	variable->assign(value);
+	Variable::assign(args[0].as_variable(), value);
 
 	return value;
 }
@@ -261,79 +446,129 @@ static Value assign(args_t& args) {
 // Evaluates the second value while the first one is truthy.
 //
 // The last value the body returned will be returned. If the body never ran, null will be returned.
-static Value while_(args_t& args) {
+static Value while_(args_t args) {
 	while (args[0].to_boolean()) {
-		args[1].run();
+		run_arg(args[1]);
 	}
 
 	return Value();
 }
 
 // Runs the second value if the first is truthy. Otherwise, runs the third value.
-static Value if_(args_t& args) {
-	return args[0].to_boolean() ? args[1].run() : args[2].run();
+static Value if_(args_t args) {
+	return args[0].to_boolean() ? run_arg(args[1]) : run_arg(args[2]);
 }
 
 // Returns a substring of the first value, with the second value as the start index and the third as the length.
 //
 // If the length is out of bounds, it's assumed to be the string length.
-static Value get(args_t& args) {
+static Value get(args_t args) {
 	auto str = args[0].to_string();
 	auto start = args[1].to_number();
-		auto length = args[2].to_number();
+	auto length = args[2].to_number();
 
-		if (start >= (number) str->length()) {
-			return Value(string());
-		}
+	if (start < 0 || length < 0)
+		throw Error("negative start or length given to 'GET'");
 
-		return Value(str->substr(start, length));
-	}
+	if (start >= (number) str->length())
+		return Value(Ref<String>::share(String::EMPTY));
+
+	return Value(str->substr(start, std::min<size_t>(length, str->length() - start)));
+}
 
 // Returns a new string with first string's range `[second, second+third)` replaced by the fourth value.
-static Value substitute(args_t& args) {
+static Value substitute(args_t args) {
 	auto str = args[0].to_string();
 	auto start = args[1].to_number();
 	auto length = args[2].to_number();
 	auto repl = args[3].to_string();
 
-	// this could be made more efficient by preallocating memory
-	return Value(str->substr(0, start) + *repl + str->substr(start + length));
-}
-
-
-void Function::initialize(void) {
-	srand(time(NULL)); // seed `R`'s random number.
-
-	Function::register_function('P', 0, &::prompt);
-	Function::register_function('R', 0, &::random);
-
-	Function::register_function('B', 1, &::block);
-	Function::register_function('C', 1, &::call);
-	Function::register_function('E', 1, &::eval);
-
-	Function::register_function('`', 1, &::system);
-	Function::register_function('Q', 1, &::quit);
-	Function::register_function('!', 1, &::not_);
-	Function::register_function('L', 1, &::length);
-	Function::register_function('D', 1, &::dump);
-	Function::register_function('O', 1, &::output);
-	Function::register_function('+', 2, &::add);
-	Function::register_function('-', 2, &::sub);
-	Function::register_function('*', 2, &::mul);
-	Function::register_function('/', 2, &::div);
-	Function::register_function('%', 2, &::mod);
-	Function::register_function('^', 2, &::pow);
-	Function::register_function('?', 2, &::eql);
-	Function::register_function('<', 2, &::lth);
-	Function::register_function('>', 2, &::gth);
-	Function::register_function('&', 2, &::and_);
-	Function::register_function('|', 2, &::or_);
-	Function::register_function(';', 2, &::then);
-	Function::register_function('=', 2, &::assign);
-	Function::register_function('W', 2, &::while_);
-
-	Function::register_function('I', 3, &::if_);
-	Function::register_function('G', 3, &::get);
-
-	Function::register_function('S', 4, &::substitute);
+	if (start < 0 || length < 0)
+		throw Error("negative start or length given to 'SUBSTITUTE'");
+
+	// out-of-bounds ranges are undefined behaviour, so we just clamp them to the string.
+	auto begin = std::min<size_t>(start, str->length());
+	auto end = std::min<size_t>(start + length, str->length());
+
+	// the prefix and suffix share `str`'s bytes, so dropping a prefix (ie `SUBSTITUTE str 0 n ""`) doesn't copy.
+	auto prefix = str->substr(0, begin);
+	auto suffix = str->substr(end, str->length() - end);
+	auto ret = String::concat(String::concat(std::move(prefix), std::move(repl)), std::move(suffix));
+
+	return Value(std::move(ret));
+}
+
+namespace {
+	// A function that can be parsed; its name is its index within the table.
+	struct Builtin {
+		funcptr_t func;
+		uint32_t arity;
+	};
+}
+
+// The builtin functions, indexed by their name; names that aren't functions have a null `func`.
+static constexpr std::array<Builtin, 256> BUILTINS = [] {
+	std::array<Builtin, 256> table {};
+
+	table['P'] = { &::prompt, 0 };
+	table['R'] = { &::random, 0 };
+
+	table['B'] = { &::block, 1 };
+	table['C'] = { &::call, 1 };
+	table['E'] = { &::eval, 1 };
+
+	table['`'] = { &::system, 1 };
+	table['Q'] = { &::quit, 1 };
+	table['!'] = { &::not_, 1 };
+	table['L'] = { &::length, 1 };
+	table['D'] = { &::dump, 1 };
+	table['O'] = { &::output, 1 };
+	table['+'] = { &quicken<Add>, 2 };
+	table['-'] = { &quicken<Sub>, 2 };
+	table['*'] = { &quicken<Mul>, 2 };
+	table['/'] = { &quicken<Div>, 2 };
+	table['%'] = { &quicken<Mod>, 2 };
+	table['^'] = { &::pow, 2 };
+	table['?'] = { &quicken<Eql>, 2 };
+	table['<'] = { &quicken<Lth>, 2 };
+	table['>'] = { &quicken<Gth>, 2 };
+	table['&'] = { &::and_, 2 };
+	table['|'] = { &::or_, 2 };
+	table[';'] = { &::then, 2 };
+	table['='] = { &::assign, 2 };
+	table['W'] = { &::while_, 2 };
+
+	table['I'] = { &::if_, 3 };
+	table['G'] = { &::get, 3 };
+
+	table['S'] = { &::substitute, 4 };
+
+	return table;
+}();
+
+// The functions that can be parsed, which is the builtins with any registered functions overlaid on top.
+//
+// This starts out as a copy of `BUILTINS` at compile time, so there's nothing to set up before parsing. It's shared by
+// every interpreter, and so must only be modified by `register_function` while no programs are running.
+static std::array<Builtin, 256> FUNCTIONS = BUILTINS;
+
+std::optional<Value> Function::create(char name, Arena& arena) {
+	auto [funcptr, arity] = FUNCTIONS[static_cast<unsigned char>(name)];
+
+	if (funcptr == nullptr)
+		return std::nullopt;
+
+	// the arguments are filled in once they're parsed, so that nodes are laid out in parse order.
+	auto memory = arena.allocate(sizeof(Function) + arity * sizeof(Value));
+	auto func = new (memory) Function(arena, funcptr, name, arity);
+
+	return std::make_optional<Value>(func);
+}
+
+funcptr_t Function::builtin(char name) noexcept {
+	return BUILTINS[static_cast<unsigned char>(name)].func;
+}
+
+void Function::register_function(char name, size_t arity, funcptr_t func) {
+	FUNCTIONS[static_cast<unsigned char>(name)] = Builtin { func, static_cast<uint32_t>(arity) };
 }
@@ -1,53 +1,157 @@
 #pragma once
 
 #include "value.hpp"
-#include <vector>
+#include "arena.hpp"
+#include "variable.hpp"
+#include "stack.hpp"
 
 namespace kn {
 	// The argument type that functions must accept.
-	using args_t = std::vector<Value>;
+	using args_t = Value*;
 
 	// The pointer type that all functions must fulfill.
-	using funcptr_t = Value(*)(args_t&);
+	using funcptr_t = Value(*)(args_t);
 
 	// The class that represents a function and its arguments within Knight.
+	//
+	// Functions are always allocated within an `Arena`, with their unevaluated arguments stored directly after them.
 	class Function {
+		// The arena that owns this function.
+		Arena& arena_;
+
 		// A pointer to the function associated with this class.
-		funcptr_t const func;
+		funcptr_t func_;
 
 		// The name of the function; used only within `DUMP`.
-		char const name;
+		char const name_;
 
-		// The unevaluated arguments associated with this function.
-		args_t args;
+		// What the function has observed while running, which builtins that specialize themselves use to record the
+		// kinds of operands they've seen.
+		uint8_t feedback_ = 0;
 
-		// Creates a function with the given function and arguments.
+		// The amount of arguments this function takes.
+		uint32_t const arity_;
+
+		// Creates a function with the given function and arity, whose arguments are all null.
 		//
-		// This is private because the only way to create a `Function` is through `parse`.
-		Function(funcptr_t func, char name, args_t args);
+		// This is private because the only ways to create a `Function` are through `parse` and `create`.
+		Function(Arena& arena, funcptr_t func, char name, uint32_t arity) noexcept;
+
+		// Functions are only ever destroyed by their `Arena`.
+		~Function();
+		friend class Arena;
+
+		// The amount of bytes this function occupies within its arena.
+		size_t allocation_size() const noexcept { return sizeof(Function) + arity_ * sizeof(Value); }
+
+		// Stores `value` as the argument at `index`; used by `Value::parse` and `Precompiled` to fill in arguments.
+		void set_arg(size_t index, Value value) noexcept;
+		friend class Value;
+		friend class Precompiled;
+
+		// Replaces the argument at `index` with `value`, which is used by the constant folder.
+		void replace_arg(size_t index, Value value) noexcept;
+		friend class ConstantFolder;
 
 	public:
 
 		// You cannot default construct Functions--you must use `parse`.
 		Function() = delete;
+		Function(Function const&) = delete;
+		Function& operator=(Function const&) = delete;
+
+		// The arena this function's memory is owned by.
+		Arena& arena() const noexcept { return arena_; }
+
+		// The function pointer that's run, and the name and arity it was registered with.
+		funcptr_t function() const noexcept { return func_; }
+		char name() const noexcept { return name_; }
+		uint32_t arity() const noexcept { return arity_; }
+
+		// The unevaluated arguments associated with this function.
+		Value* args() noexcept { return reinterpret_cast<Value*>(this + 1); }
+		Value const* args() const noexcept { return reinterpret_cast<Value const*>(this + 1); }
+
+		// Returns the function that `args` are the arguments of.
+		//
+		// This is only valid when a builtin is run from its own node (ie via `run`), and not when the virtual machine
+		// calls it with arguments from its stack.
+		static Function& from_args(Value* args) noexcept { return *(reinterpret_cast<Function*>(args) - 1); }
+
+		// Replaces the function that's run with one that does the same thing, but faster; used by the `Fuser`, and by
+		// builtins that specialize themselves.
+		void set_function(funcptr_t func) noexcept { func_ = func; }
+
+		uint8_t feedback() const noexcept { return feedback_; }
+		void set_feedback(uint8_t feedback) noexcept { feedback_ = feedback; }
 
 		// Executes this function, returning the result of the execution.
-		Value run();
+		//
+		// Throws an `Error` rather than overflowing the native stack, if the program is nested too deeply.
+		Value run() {
+			NativeStack::check();
+			return func_(args());
+		}
 
 		// Returns debugging information about this type.
 		std::ostream& dump(std::ostream& out) const;
 
-		// Attempts to parse a `Function` instance from the `string_view`.
+		// Attempts to parse a `Function` name from the `string_view`, allocating it within `arena`.
+		//
+		// Only the name is parsed: the arguments are left null, and are filled in by `Value::parse`. If the first
+		// character of `view` isn't a known `Function` name, `nullopt` is returned.
+		static std::optional<Value> parse(std::string_view& view, Arena& arena);
+
+		// Allocates the function called `name` within `arena`, with null arguments that must then be filled in.
 		//
-		// If the first character of `view` isn't a known `Function` name, `nullptr` is returned.
-		static std::optional<Value> parse(std::string_view& view);
+		// If `name` isn't a known `Function` name, `nullopt` is returned.
+		static std::optional<Value> create(char name, Arena& arena);
+
+		// Returns the builtin function called `name`, ignoring any that are registered over it; `nullptr` if there's none.
+		static funcptr_t builtin(char name) noexcept;
 
 		// Registers a new funciton with the given name, arity, and function pointer.
 		//
-		// Any previous function associated with `name` will be silently discarded.
+		// Any previous function associated with `name` will be silently discarded. As the functions are shared by all
+		// interpreters, this must not be called while any programs are running.
 		static void register_function(char name, size_t arity, funcptr_t func);
-
-		// Registers all builtin functions.
-		static void initialize();
 	};
+
+	// Runs an argument of a function.
+	//
+	// This is `Value::run`, inlined into each builtin so that running an argument that's a function is a single
+	// indirect call, rather than going through `Value::run` first.
+	inline Value run_arg(Value const& arg) {
+		if (arg.is_function())
+			return arg.as_function()->run();
+
+		if (arg.is_variable())
+			return Variable::run(arg.as_variable());
+
+		return arg;
+	}
+
+	// Runs an argument like `run_arg`, but borrows its value rather than copying it when it's a literal or variable;
+	// the results of functions are stored in `scratch`.
+	//
+	// This is for builtins that only inspect the value. The reference is only valid until something else is run, so an
+	// argument that's followed by others may need `hold_arg` instead.
+	inline Value const& borrow_arg(Value const& arg, Value& scratch) {
+		if (arg.is_function())
+			return scratch = arg.as_function()->run();
+
+		if (arg.is_variable())
+			return Variable::borrow(arg.as_variable(), scratch);
+
+		return arg;
+	}
+
+	// Like `borrow_arg`, for an argument that's followed by `next`: if `next` is a function, variables are copied, as
+	// running it could reassign them.
+	inline Value const& hold_arg(Value const& arg, Value const& next, Value& scratch) {
+		if (arg.is_variable() && next.is_function())
+			return scratch = Variable::run(arg.as_variable());
+
+		return borrow_arg(arg, scratch);
+	}
 }
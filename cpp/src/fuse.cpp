@@ -0,0 +1,194 @@
+#include "fuse.hpp"
+#include "function.hpp"
+#include <vector>
+
+using namespace kn;
+
+// Returns `value` as a function if it's a node of the builtin `name`, and `nullptr` otherwise.
+//
+// Nodes whose name has had another function registered over it, or that have already been fused, aren't builtins.
+static Function* builtin_node(Value const& value, char name) noexcept {
+	if (!value.is_function())
+		return nullptr;
+
+	auto func = value.as_function();
+	return func->name() == name && func->function() == Function::builtin(name) ? func : nullptr;
+}
+
+// Compares `lhs` with `rhs` like the builtin `Op` (one of `<`, `>` or `?`) does.
+template<char Op>
+static bool compare(Value const& lhs, Value const& rhs) {
+	if (lhs.is_number() && rhs.is_number()) {
+		auto left = lhs.as_number();
+		auto right = rhs.as_number();
+
+		return Op == '<' ? left < right : Op == '>' ? left > right : left == right;
+	}
+
+	return Op == '<' ? lhs < rhs : Op == '>' ? lhs > rhs : lhs == rhs;
+}
+
+// `= v + v n` or `= v - v n`, where `Op` is the `+` or `-`.
+template<char Op>
+static Value adjust(args_t args) {
+	auto slot = args[0].as_variable();
+	auto& amount = args[1].as_function()->args()[1];
+	auto value = Variable::run(slot);
+
+	if (value.is_number())
+		value = Value(Op == '+' ? value.as_number() + amount.as_number() : value.as_number() - amount.as_number());
+	else
+		value = Op == '+' ? value + amount : value - amount;
+
+	Variable::assign(slot, value);
+	return value;
+}
+
+// `Op v n`, for the comparison `Op`.
+template<char Op>
+static Value compare_constant(args_t args) {
+	Value scratch;
+
+	return Value(compare<Op>(Variable::borrow(args[0].as_variable(), scratch), args[1]));
+}
+
+// A chain of `;`s, which is run in a loop for as long as the second argument is another fused `;`.
+static Value sequence(args_t args) {
+	while (true) {
+		run_arg(args[0]);
+
+		auto& next = args[1];
+
+		if (!next.is_function() || next.as_function()->function() != &sequence)
+			return run_arg(next);
+
+		args = next.as_function()->args();
+	}
+}
+
+// Runs the arguments of the comparison `cond`, and returns whether `Op` holds for them.
+template<char Op>
+static bool test(Function& cond) {
+	Value lscratch, rscratch;
+	auto& lhs = hold_arg(cond.args()[0], cond.args()[1], lscratch);
+
+	return compare<Op>(lhs, borrow_arg(cond.args()[1], rscratch));
+}
+
+// `IF` on the comparison `Op`.
+template<char Op>
+static Value if_compare(args_t args) {
+	return test<Op>(*args[0].as_function()) ? run_arg(args[1]) : run_arg(args[2]);
+}
+
+// `WHILE` on the comparison `Op`.
+template<char Op>
+static Value while_compare(args_t args) {
+	auto& cond = *args[0].as_function();
+
+	while (test<Op>(cond))
+		run_arg(args[1]);
+
+	return Value();
+}
+
+// Returns whether `value` is a node of one of the builtin comparisons, storing its name in `op` if so.
+static bool is_comparison(Value const& value, char& op) noexcept {
+	for (char name : { '<', '>', '?' }) {
+		if (builtin_node(value, name)) {
+			op = name;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Fuser::fuse_function(Function& func) {
+	if (func.function() != Function::builtin(func.name()))
+		return;
+
+	auto args = func.args();
+	char op;
+
+	switch (func.name()) {
+	case '=':
+		if (!args[0].is_variable())
+			return;
+
+		for (char name : { '+', '-' }) {
+			auto adjustment = builtin_node(args[1], name);
+
+			if (!adjustment || !adjustment->args()[0].is_variable() || !adjustment->args()[1].is_number()
+				|| adjustment->args()[0].as_variable() != args[0].as_variable())
+				continue;
+
+			func.set_function(name == '+' ? &adjust<'+'> : &adjust<'-'>);
+			++increments_;
+			return;
+		}
+
+		return;
+
+	case '<':
+	case '>':
+	case '?':
+		if (!args[0].is_variable() || !args[1].is_number())
+			return;
+
+		func.set_function(func.name() == '<' ? &compare_constant<'<'>
+			: func.name() == '>' ? &compare_constant<'>'> : &compare_constant<'?'>);
+		++comparisons_;
+		return;
+
+	case ';':
+		if (!builtin_node(args[1], ';'))
+			return;
+
+		func.set_function(&sequence);
+		++sequences_;
+		return;
+
+	case 'I':
+		if (!is_comparison(args[0], op))
+			return;
+
+		func.set_function(op == '<' ? &if_compare<'<'> : op == '>' ? &if_compare<'>'> : &if_compare<'?'>);
+		++branches_;
+		return;
+
+	case 'W':
+		if (!is_comparison(args[0], op))
+			return;
+
+		func.set_function(op == '<' ? &while_compare<'<'> : op == '>' ? &while_compare<'>'> : &while_compare<'?'>);
+		++branches_;
+		return;
+	}
+}
+
+void Fuser::fuse_value(Value& program) {
+	if (!program.is_function())
+		return;
+
+	// parents are fused before their arguments, as whether a parent can be fused depends on its arguments still being
+	// the original builtins.
+	std::vector<Function*> pending { program.as_function() };
+
+	while (!pending.empty()) {
+		auto func = pending.back();
+		pending.pop_back();
+
+		fuse_function(*func);
+
+		for (uint32_t i = 0; i < func->arity(); ++i) {
+			if (func->args()[i].is_function())
+				pending.push_back(func->args()[i].as_function());
+		}
+	}
+}
+
+std::ostream& Fuser::dump_stats(std::ostream& out) const {
+	return out << "fusion: " << increments_ << " increments, " << comparisons_ << " comparisons, " << sequences_
+		<< " sequences, " << branches_ << " branches" << std::endl;
+}
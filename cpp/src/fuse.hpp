@@ -0,0 +1,53 @@
+#pragma once
+
+#include "value.hpp"
+#include <ostream>
+#include <cstddef>
+
+namespace kn {
+	// An optimization pass that's run on programs after they're parsed (and folded), which replaces the functions of
+	// common idioms with fused ones that run the entire idiom at once:
+	//
+	// - `= v + v n` and `= v - v n`, which adjust the variable `v` by the number `n`;
+	// - `< v n`, `> v n` and `? v n`, which compare the variable `v` with the number `n`;
+	// - `; a ; b ...`, whose chains of `;`s are run in a loop, rather than recursively;
+	// - `IF` and `WHILE` on a `<`, `>` or `?`, which branch on the comparison without creating a boolean first.
+	//
+	// Fused functions have a fast path for numbers, and otherwise do exactly what the original functions do. Only the
+	// function pointers of nodes are replaced, so fused programs still `DUMP` the same way. The virtual machine
+	// compiles all of these nodes by name, so this only speeds up the tree-walking interpreter.
+	class Fuser {
+		// Whether the pass is run at all; it's on by default.
+		bool enabled_ = true;
+
+		// The amount of nodes that have been replaced by each kind of fused function.
+		size_t increments_ = 0;
+		size_t comparisons_ = 0;
+		size_t sequences_ = 0;
+		size_t branches_ = 0;
+
+		// Fuses `func`, if it's one of the idioms; its arguments are left alone.
+		void fuse_function(Function& func);
+
+		// Fuses every function within `program`, parents before their arguments.
+		void fuse_value(Value& program);
+
+	public:
+		void enable(bool enabled = true) noexcept { enabled_ = enabled; }
+		bool enabled() const noexcept { return enabled_; }
+
+		size_t increments() const noexcept { return increments_; }
+		size_t comparisons() const noexcept { return comparisons_; }
+		size_t sequences() const noexcept { return sequences_; }
+		size_t branches() const noexcept { return branches_; }
+
+		// Fuses the idioms within `program` in place, if the pass is enabled.
+		void fuse(Value& program) {
+			if (enabled_)
+				fuse_value(program);
+		}
+
+		// Writes the amount of each kind of fusion to `out`.
+		std::ostream& dump_stats(std::ostream& out) const;
+	};
+}
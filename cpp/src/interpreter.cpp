@@ -0,0 +1,16 @@
+#include "interpreter.hpp"
+#include "knight.hpp"
+
+using namespace kn;
+
+Interpreter::Interpreter(std::istream& input, int output_fd)
+	: output(output_fd), input(input), random(std::random_device()()) {}
+
+Interpreter::Interpreter(std::istream& input)
+	: output(), input(input), random(std::random_device()()) {}
+
+Value Interpreter::run(std::string_view source) {
+	Scope scope(*this);
+
+	return kn::run(source);
+}
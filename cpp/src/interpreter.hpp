@@ -0,0 +1,101 @@
+#pragma once
+
+#include "value.hpp"
+#include "environment.hpp"
+#include "eval_cache.hpp"
+#include "fold.hpp"
+#include "fuse.hpp"
+#include "jit.hpp"
+#include "output.hpp"
+#include "stack.hpp"
+#include <istream>
+#include <random>
+#include <string_view>
+
+namespace kn {
+	// The ways that Knight programs can be executed.
+	enum class Engine {
+		// Recursively walk the parsed tree, via `Value::run`.
+		Tree,
+
+		// Compile the parsed tree into bytecode, and run it in the `Vm`.
+		Vm
+	};
+
+	// Thrown by `QUIT` to stop the program that's running, rather than exiting the whole process.
+	struct Quit {
+		int status;
+	};
+
+	// All the state of a running Knight program.
+	//
+	// Interpreters are completely independent of each other, so any amount of them can be run at once, as long as
+	// each one is only used by a single thread at a time. The functions that make up a program find their
+	// interpreter through `current`, which is set by a `Scope`.
+	class Interpreter {
+		static inline thread_local Interpreter* current_ = nullptr;
+
+	public:
+		// The engine that `execute` uses; defaults to `Engine::Tree`.
+		Engine engine = Engine::Tree;
+
+		// The program's variables.
+		Environment environment;
+
+		// The cache used by `EVAL`.
+		EvalCache eval_cache;
+
+		// The passes that `optimize` runs.
+		ConstantFolder constant_folder;
+		Jit jit;
+		Fuser fuser;
+
+		// Where `OUTPUT` and `DUMP` write to.
+		Output output;
+
+		// Where `PROMPT` reads from.
+		std::istream& input;
+
+		// The generator used by `RANDOM`.
+		std::mt19937 random;
+
+		// Creates an interpreter that reads from `input`, and writes to the file descriptor `output_fd`.
+		Interpreter(std::istream& input, int output_fd);
+
+		// Creates an interpreter that reads from `input`, and whose output is captured in memory.
+		explicit Interpreter(std::istream& input);
+
+		Interpreter(Interpreter const&) = delete;
+		Interpreter& operator=(Interpreter const&) = delete;
+
+		// Makes an interpreter the current one of this thread, until it's destroyed.
+		class Scope {
+			Interpreter* previous;
+
+		public:
+			explicit Scope(Interpreter& interpreter) noexcept : previous(current_) {
+				current_ = &interpreter;
+				NativeStack::prepare();
+			}
+			~Scope() { current_ = previous; }
+
+			Scope(Scope const&) = delete;
+			Scope& operator=(Scope const&) = delete;
+		};
+
+		// The interpreter that's running on this thread; it's undefined behaviour to call this outside of a `Scope`.
+		static Interpreter& current() noexcept { return *current_; }
+
+		// Runs the optimization passes over `program`, which must have just been parsed (or loaded).
+		void optimize(Value& program) {
+			constant_folder.fold(program);
+			jit.prepare(program);
+			fuser.fuse(program);
+		}
+
+		// Parses and runs `source` as the current interpreter, returning its result.
+		//
+		// Throws an `Error` if the program is invalid or fails, and `Quit` if it calls `QUIT`.
+		Value run(std::string_view source);
+	};
+}
@@ -0,0 +1,561 @@
+#include "jit.hpp"
+#include "function.hpp"
+#include "interpreter.hpp"
+#include <algorithm>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <mutex>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace kn;
+
+#if defined(__x86_64__) && defined(__linux__)
+const bool Jit::SUPPORTED = true;
+#else
+const bool Jit::SUPPORTED = false;
+#endif
+
+// The most nodes a loop can have to be compiled; this also bounds how deeply the compiler recurses.
+static constexpr size_t MAX_LOOP_NODES = 1024;
+
+// What compiled code returns: zero once the loop has finished, and otherwise why it stopped early. Reading the
+// unassigned variable at `slot` returns `(slot << 2) | UNASSIGNED`.
+enum : uint64_t {
+	FINISHED = 0,
+	UNASSIGNED = 1,
+	DIVIDED_BY_ZERO = 2,
+	MODULO_BY_ZERO = 3
+};
+
+namespace {
+	// Emits x86-64 machine code.
+	//
+	// Only the handful of instructions the templates need are supported, so they're written out as raw bytes. Values
+	// are computed in `rax`, with `rcx` and `rdx` as scratch registers, and `rbx` pointing to the variables.
+	struct Assembler {
+		// The opcodes of the conditional jumps that are used, after their `0x0f` prefix.
+		enum Condition : uint8_t {
+			IF_ZERO = 0x84,
+			IF_NOT_ZERO = 0x85,
+			IF_EQUAL = 0x84,
+			IF_NOT_EQUAL = 0x85
+		};
+
+		std::vector<uint8_t> code;
+
+		size_t here() const noexcept { return code.size(); }
+
+		void bytes(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+
+		void u32(uint32_t value) {
+			for (int i = 0; i < 4; ++i)
+				code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+
+		void u64(uint64_t value) {
+			for (int i = 0; i < 8; ++i)
+				code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+
+		// Emits a jump whose target is filled in later by `patch`; returns the location of the target.
+		size_t jump() {
+			bytes({ 0xe9 });
+			u32(0);
+			return here() - 4;
+		}
+
+		size_t jump(Condition condition) {
+			bytes({ 0x0f, condition });
+			u32(0);
+			return here() - 4;
+		}
+
+		// Emits a jump backwards to `target`.
+		void jump_to(size_t target) { patch(jump(), target); }
+
+		// Sets the jump target at `location` to `target`, or to the next instruction.
+		void patch(size_t location, size_t target) {
+			auto offset = static_cast<uint32_t>(static_cast<int32_t>(target - (location + 4)));
+
+			for (int i = 0; i < 4; ++i)
+				code[location + i] = static_cast<uint8_t>(offset >> (8 * i));
+		}
+
+		void patch(size_t location) { patch(location, here()); }
+
+		void mov_rax(uint64_t immediate) { bytes({ 0x48, 0xb8 }); u64(immediate); }  // mov rax, imm64
+		void push_rax() { bytes({ 0x50 }); }                                          // push rax
+		void pop_rax() { bytes({ 0x58 }); }                                           // pop rax
+		void mov_rcx_rax() { bytes({ 0x48, 0x89, 0xc1 }); }                           // mov rcx, rax
+		void test_rax() { bytes({ 0x48, 0x85, 0xc0 }); }                              // test rax, rax
+		void test_rcx() { bytes({ 0x48, 0x85, 0xc9 }); }                              // test rcx, rcx
+		void zero_eax() { bytes({ 0x31, 0xc0 }); }                                    // xor eax, eax
+
+		// Wraps `rax` around to 63 bits, which is all that a number `Value` holds.
+		void truncate_rax() {
+			bytes({ 0x48, 0xd1, 0xe0 }); // shl rax, 1
+			bytes({ 0x48, 0xd1, 0xf8 }); // sar rax, 1
+		}
+
+		// Sets `rax` to one if the condition `setcc` (eg `0x9c` for `setl`) holds, and zero otherwise.
+		void set_rax(uint8_t setcc) {
+			bytes({ 0x0f, setcc, 0xc0 }); // setcc al
+			bytes({ 0x0f, 0xb6, 0xc0 });  // movzx eax, al
+		}
+
+		// Loads the variable at `slot` into `rax`, still tagged.
+		void load(slot_t slot) {
+			bytes({ 0x48, 0x8b, 0x83 }); // mov rax, [rbx + disp32]
+			u32(slot * sizeof(Value));
+		}
+
+		// Stores the number in `rax` into the variable at `slot`, tagging it.
+		void store(slot_t slot) {
+			bytes({ 0x48, 0x8d, 0x4c, 0x00, 0x01 }); // lea rcx, [rax + rax + 1]
+			bytes({ 0x48, 0x89, 0x8b });             // mov [rbx + disp32], rcx
+			u32(slot * sizeof(Value));
+		}
+	};
+
+	// The kinds of values that compiled code deals with. They're all held in `rax` as their numeric value, so any of
+	// them can be used where a number or boolean is expected.
+	enum class Kind {
+		Number,
+		Boolean,
+		Null,
+
+		// The result of an `IF` whose branches have different kinds.
+		Mixed
+	};
+
+	// Compiles a single `WHILE` loop.
+	class Compiler {
+		Assembler as;
+
+		// The variables that the loop touches.
+		std::vector<slot_t> slots;
+
+		// The jumps to the code that returns an error, along with the slot for `unassigned` ones.
+		std::vector<std::pair<size_t, slot_t>> unassigned;
+		std::vector<size_t> divided_by_zero;
+		std::vector<size_t> modulo_by_zero;
+
+		size_t nodes = 0;
+
+		void use(slot_t slot) {
+			if (std::find(slots.cbegin(), slots.cend(), slot) == slots.cend())
+				slots.push_back(slot);
+		}
+
+		// Emits the code that evaluates `value` into `rax`, returning its kind; or `nullopt` if it can't be compiled.
+		std::optional<Kind> expression(Value const& value);
+		std::optional<Kind> function(Function& func);
+
+		// Emits `lhs` into `rax` and `rhs` into `rcx`, returning their kinds.
+		std::optional<std::pair<Kind, Kind>> operands(Value const& lhs, Value const& rhs);
+
+		// Emits a jump to the code that returns `error`.
+		void fail_if_zero(std::vector<size_t>& jumps) { jumps.push_back(as.jump(Assembler::IF_ZERO)); }
+
+		// Emits the code that returns `result` for each of `jumps`, which then jumps to `exit`.
+		void returns(std::vector<size_t> const& jumps, uint64_t result, size_t exit) {
+			if (jumps.empty())
+				return;
+
+			for (auto jump : jumps)
+				as.patch(jump);
+
+			as.mov_rax(result);
+			as.jump_to(exit);
+		}
+
+	public:
+		// Compiles `loop` into a function taking a pointer to the variables, or `nullopt` if it can't be compiled.
+		std::optional<NativeCode::Loop> compile(Function& loop);
+	};
+}
+
+std::optional<NativeCode::Loop> Compiler::compile(Function& loop) {
+	as.bytes({ 0x55 });             // push rbp
+	as.bytes({ 0x48, 0x89, 0xe5 }); // mov rbp, rsp
+	as.bytes({ 0x53 });             // push rbx
+	as.bytes({ 0x48, 0x89, 0xfb }); // mov rbx, rdi
+
+	if (!function(loop))
+		return std::nullopt;
+
+	as.zero_eax();
+
+	// errors can happen partway through an expression, so the stack is restored from `rbp` rather than popped.
+	auto exit = as.here();
+	as.bytes({ 0x48, 0x8d, 0x65, 0xf8 }); // lea rsp, [rbp - 8]
+	as.bytes({ 0x5b });                   // pop rbx
+	as.bytes({ 0x5d });                   // pop rbp
+	as.bytes({ 0xc3 });                   // ret
+
+	for (auto [jump, slot] : unassigned) {
+		as.patch(jump);
+		as.mov_rax((static_cast<uint64_t>(slot) << 2) | UNASSIGNED);
+		as.jump_to(exit);
+	}
+
+	returns(divided_by_zero, DIVIDED_BY_ZERO, exit);
+	returns(modulo_by_zero, MODULO_BY_ZERO, exit);
+
+	return NativeCode::Loop { std::move(as.code), std::move(slots) };
+}
+
+std::optional<Kind> Compiler::expression(Value const& value) {
+	if (value.is_function())
+		return function(*value.as_function());
+
+	if (value.is_variable()) {
+		auto slot = value.as_variable();
+		use(slot);
+
+		// numbers are the only values with their lowest bit set, which is all the variable can hold besides being
+		// unassigned, as the loop is only entered if all of its variables are numbers.
+		as.load(slot);
+		as.bytes({ 0xa8, 0x01 }); // test al, 1
+		unassigned.emplace_back(as.jump(Assembler::IF_ZERO), slot);
+		as.bytes({ 0x48, 0xd1, 0xf8 }); // sar rax, 1
+		return Kind::Number;
+	}
+
+	if (value.is_number()) {
+		as.mov_rax(static_cast<uint64_t>(value.as_number()));
+		return Kind::Number;
+	}
+
+	if (value.is_boolean()) {
+		Value copy(value);
+		as.mov_rax(copy.to_boolean());
+		return Kind::Boolean;
+	}
+
+	if (value.is_null()) {
+		as.mov_rax(0);
+		return Kind::Null;
+	}
+
+	return std::nullopt;
+}
+
+std::optional<std::pair<Kind, Kind>> Compiler::operands(Value const& lhs, Value const& rhs) {
+	auto left = expression(lhs);
+	if (!left)
+		return std::nullopt;
+
+	as.push_rax();
+
+	auto right = expression(rhs);
+	if (!right)
+		return std::nullopt;
+
+	as.mov_rcx_rax();
+	as.pop_rax();
+
+	return std::make_pair(*left, *right);
+}
+
+std::optional<Kind> Compiler::function(Function& func) {
+	// functions that something else has been registered over, or that have already been fused, aren't compiled.
+	if (MAX_LOOP_NODES < ++nodes || func.function() != Function::builtin(func.name()))
+		return std::nullopt;
+
+	auto args = func.args();
+	std::optional<std::pair<Kind, Kind>> kinds;
+	std::optional<Kind> kind;
+
+	switch (func.name()) {
+	// the arithmetic functions need a number on the left, but convert anything on the right to a number, which the
+	// value in `rax` already is.
+	case '+': case '-': case '*': case '/': case '%':
+		if (!(kinds = operands(args[0], args[1])) || kinds->first != Kind::Number)
+			return std::nullopt;
+
+		switch (func.name()) {
+		case '+': as.bytes({ 0x48, 0x01, 0xc8 }); break;       // add rax, rcx
+		case '-': as.bytes({ 0x48, 0x29, 0xc8 }); break;       // sub rax, rcx
+		case '*': as.bytes({ 0x48, 0x0f, 0xaf, 0xc1 }); break; // imul rax, rcx
+		case '/':
+		case '%': {
+			as.test_rcx();
+			fail_if_zero(func.name() == '/' ? divided_by_zero : modulo_by_zero);
+
+			// `idiv` traps on overflow, so dividing by -1 is done by hand.
+			as.bytes({ 0x48, 0x83, 0xf9, 0xff }); // cmp rcx, -1
+			auto divide = as.jump(Assembler::IF_NOT_EQUAL);
+
+			if (func.name() == '/')
+				as.bytes({ 0x48, 0xf7, 0xd8 }); // neg rax
+			else
+				as.zero_eax();
+
+			auto end = as.jump();
+			as.patch(divide);
+			as.bytes({ 0x48, 0x99 });       // cqo
+			as.bytes({ 0x48, 0xf7, 0xf9 }); // idiv rcx
+
+			if (func.name() == '%')
+				as.bytes({ 0x48, 0x89, 0xd0 }); // mov rax, rdx
+
+			as.patch(end);
+			break;
+		}
+		}
+
+		// results wrap around the same way as they do when stored in a `Value`, so they match the other engines.
+		as.truncate_rax();
+		return Kind::Number;
+
+	case '<':
+	case '>':
+		if (!(kinds = operands(args[0], args[1])) || kinds->first != Kind::Number)
+			return std::nullopt;
+
+		as.bytes({ 0x48, 0x39, 0xc8 }); // cmp rax, rcx
+		as.set_rax(func.name() == '<' ? 0x9c : 0x9f); // setl / setg
+		return Kind::Boolean;
+
+	// values of different kinds are never equal, and values of the same kind are equal when their numeric values are.
+	case '?':
+		if (!(kinds = operands(args[0], args[1])) || kinds->first != kinds->second || kinds->first == Kind::Mixed)
+			return std::nullopt;
+
+		as.bytes({ 0x48, 0x39, 0xc8 }); // cmp rax, rcx
+		as.set_rax(0x94); // sete
+		return Kind::Boolean;
+
+	case '!':
+		if (!expression(args[0]))
+			return std::nullopt;
+
+		as.test_rax();
+		as.set_rax(0x94); // sete
+		return Kind::Boolean;
+
+	// these return one of their arguments, so they both have to be the same kind.
+	case '&':
+	case '|': {
+		auto left = expression(args[0]);
+		if (!left || *left == Kind::Mixed)
+			return std::nullopt;
+
+		as.test_rax();
+		auto end = as.jump(func.name() == '&' ? Assembler::IF_ZERO : Assembler::IF_NOT_ZERO);
+
+		if (expression(args[1]) != left)
+			return std::nullopt;
+
+		as.patch(end);
+		return left;
+	}
+
+	case ';':
+		if (!expression(args[0]))
+			return std::nullopt;
+
+		return expression(args[1]);
+
+	// only numbers are ever stored, so that variables stay numbers while the loop runs.
+	case '=':
+		if (!args[0].is_variable() || expression(args[1]) != Kind::Number)
+			return std::nullopt;
+
+		use(args[0].as_variable());
+		as.store(args[0].as_variable());
+		return Kind::Number;
+
+	case 'I': {
+		if (!expression(args[0]))
+			return std::nullopt;
+
+		as.test_rax();
+		auto otherwise = as.jump(Assembler::IF_ZERO);
+
+		auto then = expression(args[1]);
+		if (!then)
+			return std::nullopt;
+
+		auto end = as.jump();
+		as.patch(otherwise);
+
+		auto els = expression(args[2]);
+		if (!els)
+			return std::nullopt;
+
+		as.patch(end);
+		return then == els ? then : Kind::Mixed;
+	}
+
+	case 'W': {
+		auto top = as.here();
+
+		if (!expression(args[0]))
+			return std::nullopt;
+
+		as.test_rax();
+		auto end = as.jump(Assembler::IF_ZERO);
+
+		if (!expression(args[1]))
+			return std::nullopt;
+
+		as.jump_to(top);
+		as.patch(end);
+		as.zero_eax();
+		return Kind::Null;
+	}
+
+	default:
+		return std::nullopt;
+	}
+}
+
+NativeCode::~NativeCode() {
+	for (auto& [func, loop] : loops) {
+		if (loop.memory != nullptr)
+			munmap(loop.memory, loop.mapped);
+	}
+}
+
+// Records the code at `memory` in `/tmp/perf-<pid>.map`, so that `perf` can name it.
+static void record(void const* memory, size_t size) {
+	static std::mutex mutex;
+	static FILE* map = nullptr;
+	static size_t count = 0;
+
+	std::lock_guard lock(mutex);
+
+	if (map == nullptr) {
+		auto path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+
+		if ((map = std::fopen(path.c_str(), "a")) == nullptr)
+			return;
+	}
+
+	std::fprintf(map, "%" PRIxPTR " %zx knight_jit_while_%zu\n", reinterpret_cast<uintptr_t>(memory), size, count++);
+	std::fflush(map);
+}
+
+// Copies the code of `loop` into executable memory, returning false if it can't be.
+static bool map(NativeCode::Loop& loop) {
+	if (loop.failed)
+		return false;
+
+	auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	auto size = (loop.bytes.size() + page - 1) / page * page;
+	auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (memory == MAP_FAILED) {
+		loop.failed = true;
+		return false;
+	}
+
+	std::memcpy(memory, loop.bytes.data(), loop.bytes.size());
+
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(memory, size);
+		loop.failed = true;
+		return false;
+	}
+
+	loop.memory = memory;
+	loop.mapped = size;
+	record(memory, loop.bytes.size());
+
+	return true;
+}
+
+// Raises the error that compiled code stopped with, by doing what made it stop in the interpreter.
+static void raise(uint64_t result) {
+	switch (result) {
+	case DIVIDED_BY_ZERO:
+		(void) (Value(static_cast<number>(1)) / Value(static_cast<number>(0)));
+		break;
+
+	case MODULO_BY_ZERO:
+		(void) (Value(static_cast<number>(1)) % Value(static_cast<number>(0)));
+		break;
+
+	default:
+		(void) Variable::run(static_cast<slot_t>(result >> 2));
+		break;
+	}
+}
+
+// What compiled `WHILE` nodes run instead of `WHILE`.
+static Value jit_while(args_t args) {
+	if (!Interpreter::current().jit.run(Function::from_args(args))) {
+		while (args[0].to_boolean())
+			run_arg(args[1]);
+	}
+
+	return Value();
+}
+
+bool Jit::run(Function& node) {
+	auto& loops = node.arena().native_code().loops;
+	auto match = loops.find(&node);
+
+	if (match == loops.end())
+		return false;
+
+	auto& loop = match->second;
+
+	if (loop.memory == nullptr && !map(loop))
+		return false;
+
+	auto values = Interpreter::current().environment.data();
+
+	for (auto slot : loop.slots) {
+		if (!values[slot].is_number() && !values[slot].is_undefined()) {
+			++guard_failures_;
+			return false;
+		}
+	}
+
+	++entered_;
+
+	auto result = reinterpret_cast<uint64_t (*)(Value*)>(loop.memory)(values);
+
+	if (result != FINISHED)
+		raise(result);
+
+	return true;
+}
+
+void Jit::prepare_value(Value& program) {
+	if (!program.is_function())
+		return;
+
+	std::vector<Function*> pending { program.as_function() };
+
+	while (!pending.empty()) {
+		auto func = pending.back();
+		pending.pop_back();
+
+		if (func->name() == 'W' && func->function() == Function::builtin('W')) {
+			if (auto loop = Compiler().compile(*func)) {
+				func->arena().native_code().loops.emplace(func, std::move(*loop));
+				func->set_function(&jit_while);
+				++compiled_;
+			}
+		}
+
+		for (uint32_t i = 0; i < func->arity(); ++i) {
+			if (func->args()[i].is_function())
+				pending.push_back(func->args()[i].as_function());
+		}
+	}
+}
+
+std::ostream& Jit::dump_stats(std::ostream& out) const {
+	return out << "jit: " << compiled_ << " loops compiled, " << entered_ << " entered, " << guard_failures_
+		<< " interpreted due to their variables" << std::endl;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "value.hpp"
+#include <unordered_map>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+namespace kn {
+	// The machine code compiled from the loops of a single `Arena`, which is freed along with it.
+	class NativeCode {
+		friend class Jit;
+
+	public:
+		struct Loop {
+			// The loop's code; it's only copied into executable memory the first time it's run.
+			std::vector<uint8_t> bytes;
+
+			// Every variable the loop reads or assigns, which are checked before it's entered.
+			std::vector<slot_t> slots;
+
+			// The executable copy of `bytes`, and the size of its mapping.
+			void* memory = nullptr;
+			size_t mapped = 0;
+
+			// Whether mapping the code failed, in which case it's always interpreted instead.
+			bool failed = false;
+		};
+
+	private:
+		std::unordered_map<Function const*, Loop> loops;
+
+	public:
+		NativeCode() = default;
+		NativeCode(NativeCode const&) = delete;
+		NativeCode& operator=(NativeCode const&) = delete;
+
+		// Unmaps all of the loops.
+		~NativeCode();
+	};
+
+	// An optional template JIT, which compiles `WHILE` loops that only deal with numbers into x86-64 machine code.
+	//
+	// A loop can be compiled if it's only made of number literals, `TRUE`, `FALSE`, `NULL`, variables, and the
+	// functions `+ - * / % < > ? ! & | ; = IF WHILE`, in ways that never need anything but a number to be stored in a
+	// variable. Each function is emitted from a fixed template, with intermediate results in registers and on the
+	// machine stack, and variables read and written directly within the interpreter's `Environment`.
+	//
+	// Loops are compiled when a program is optimized, and mapped into executable memory the first time they run. Each
+	// time a compiled loop is entered, every variable it touches must be a number (or unassigned); if any isn't, the
+	// loop is interpreted instead. As nothing else runs while it's executing, the variables can't change kinds until it
+	// exits. Errors (reading unassigned variables, and dividing by zero) leave the loop at that point and are then
+	// raised exactly like the interpreter raises them.
+	//
+	// The JIT only exists on x86-64 Linux; elsewhere, enabling it does nothing. As it replaces the function of `WHILE`
+	// nodes, it only affects the tree-walking interpreter.
+	class Jit {
+		bool enabled_ = false;
+
+		// The amount of loops that have been compiled, entered, and interpreted due to a variable's kind.
+		size_t compiled_ = 0;
+		size_t entered_ = 0;
+		size_t guard_failures_ = 0;
+
+		// Compiles each loop in `program` that can be.
+		void prepare_value(Value& program);
+
+	public:
+		// Whether this platform has a JIT at all.
+		static const bool SUPPORTED;
+
+		void enable(bool enabled = true) noexcept { enabled_ = enabled && SUPPORTED; }
+		bool enabled() const noexcept { return enabled_; }
+
+		size_t compiled() const noexcept { return compiled_; }
+		size_t entered() const noexcept { return entered_; }
+		size_t guard_failures() const noexcept { return guard_failures_; }
+
+		// Compiles the loops in `program`, which must have just been parsed, if the JIT is enabled.
+		void prepare(Value& program) {
+			if (enabled_)
+				prepare_value(program);
+		}
+
+		// Runs the compiled `WHILE` loop `node`, returning false without running anything if it must be interpreted.
+		bool run(Function& node);
+
+		// Writes the JIT's counters to `out`.
+		std::ostream& dump_stats(std::ostream& out) const;
+	};
+}
@@ -1,6 +0,0 @@
-#include "knight.hpp"
-#include "function.hpp"
-
-void kn::initialize() {
-	Function::initialize();
-}
@@ -1,21 +1,30 @@
 #pragma once
 
 #include "value.hpp"
+#include "vm.hpp"
+#include "interpreter.hpp"
 #include <iostream>
 
 namespace kn {
-	// Initializes the Knight interpreter. This must be run before all other types are.
-	void initialize();
+	// Runs an already-parsed program with the current interpreter's `engine`, returning its result.
+	inline Value execute(Value const& program) {
+		return Interpreter::current().engine == Engine::Vm ? Vm::run(program) : Value(program).run();
+	}
 
-	// Runs the input as Knight source code, returning its result.
-	template<typename T>
-	Value run(T input) {
-		std::string_view view(input);
-		auto value = Value::parse(view);
+	// Parses the input as Knight source code, and optimizes it with the current interpreter.
+	inline Value parse(std::string_view input) {
+		auto value = Value::parse(input);
 
 		if (!value)
 			throw Error("cannot parse a value");
 
-		return value->run();
+		Interpreter::current().optimize(*value);
+		return std::move(*value);
+	}
+
+	// Runs the input as Knight source code, returning its result.
+	template<typename T>
+	Value run(T input) {
+		return execute(parse(std::string_view(input)));
 	}
 }
@@ -0,0 +1,60 @@
+#include "codegen.hpp"
+#include "interpreter.hpp"
+#include "source.hpp"
+#include <iostream>
+#include <fstream>
+#include <optional>
+#include <unistd.h>
+
+using namespace kn;
+
+void usage(char const* program) {
+	std::cerr << "usage: " << program << " (-e 'expression' | -f file) [-o out.cpp]\n"
+		"the output is compiled with: c++ -std=c++17 -O2 -Isrc out.cpp libknight.a -pthread" << std::endl;
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	if (argc != 3 && !(argc == 5 && std::string_view(argv[3]) == "-o"))
+		usage(argv[0]);
+
+	// the interpreter is only used for its environment, which gives out the slots the generated code uses.
+	Interpreter interpreter(std::cin, STDOUT_FILENO);
+	Interpreter::Scope scope(interpreter);
+
+	try {
+		std::string_view mode(argv[1]);
+		std::optional<SourceFile> file;
+		std::string_view source;
+
+		if (mode == "-e")
+			source = argv[2];
+		else if (mode == "-f")
+			source = file.emplace(argv[2]).view();
+		else
+			usage(argv[0]);
+
+		auto program = Value::parse(source);
+
+		if (!program)
+			throw Error("cannot parse a value");
+
+		auto code = CodeGenerator::generate(*program);
+
+		if (argc == 3) {
+			std::cout << code;
+			return 0;
+		}
+
+		std::ofstream out(argv[4], std::ios::binary | std::ios::trunc);
+		out << code;
+
+		if (!out)
+			throw Error(std::string("unable to write '") + argv[4] + "'");
+	} catch (std::exception& err) {
+		std::cerr << "error with your code: " << err.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+#include "lexer.hpp"
+#include <cstring>
+
+// Defining `KN_LEXER_SCALAR` disables the vectorized scanners, leaving only the table-driven ones.
+#if !defined(KN_LEXER_SCALAR) && (defined(__AVX2__) || defined(__SSE2__))
+# include <immintrin.h>
+#endif
+
+using namespace kn;
+
+namespace {
+#if !defined(KN_LEXER_SCALAR) && defined(__AVX2__)
+	// 32 bytes at a time.
+	using vector = __m256i;
+	using mask_t = uint32_t;
+	constexpr size_t WIDTH = 32;
+
+	vector load(char const* ptr) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr)); }
+	vector splat(char c) { return _mm256_set1_epi8(c); }
+	vector equal(vector lhs, vector rhs) { return _mm256_cmpeq_epi8(lhs, rhs); }
+	vector either(vector lhs, vector rhs) { return _mm256_or_si256(lhs, rhs); }
+	vector sub(vector lhs, vector rhs) { return _mm256_sub_epi8(lhs, rhs); }
+	vector min(vector lhs, vector rhs) { return _mm256_min_epu8(lhs, rhs); }
+	mask_t movemask(vector vec) { return static_cast<mask_t>(_mm256_movemask_epi8(vec)); }
+# define KN_LEXER_SIMD
+#elif !defined(KN_LEXER_SCALAR) && defined(__SSE2__)
+	// 16 bytes at a time.
+	using vector = __m128i;
+	using mask_t = uint32_t;
+	constexpr size_t WIDTH = 16;
+
+	vector load(char const* ptr) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr)); }
+	vector splat(char c) { return _mm_set1_epi8(c); }
+	vector equal(vector lhs, vector rhs) { return _mm_cmpeq_epi8(lhs, rhs); }
+	vector either(vector lhs, vector rhs) { return _mm_or_si128(lhs, rhs); }
+	vector sub(vector lhs, vector rhs) { return _mm_sub_epi8(lhs, rhs); }
+	vector min(vector lhs, vector rhs) { return _mm_min_epu8(lhs, rhs); }
+	mask_t movemask(vector vec) { return static_cast<mask_t>(_mm_movemask_epi8(vec)); }
+# define KN_LEXER_SIMD
+#endif
+
+#ifdef KN_LEXER_SIMD
+	constexpr mask_t ALL = WIDTH == 32 ? ~mask_t(0) : (mask_t(1) << WIDTH) - 1;
+
+	// Marks the bytes of `vec` that are within `[lo, hi]`: they're in range iff `vec - lo <= hi - lo` when unsigned.
+	vector in_range(vector vec, char lo, char hi) {
+		auto offset = sub(vec, splat(lo));
+		return equal(min(offset, splat(hi - lo)), offset);
+	}
+
+	vector whitespace(vector vec) {
+		auto ret = in_range(vec, '\t', '\r');
+		ret = either(ret, equal(vec, splat(' ')));
+		ret = either(ret, in_range(vec, '(', ')'));
+		ret = either(ret, equal(vec, splat(':')));
+		ret = either(ret, equal(vec, splat('[')));
+		ret = either(ret, equal(vec, splat(']')));
+		ret = either(ret, equal(vec, splat('{')));
+		return either(ret, equal(vec, splat('}')));
+	}
+
+	vector identifier(vector vec) {
+		auto ret = in_range(vec, 'a', 'z');
+		ret = either(ret, in_range(vec, '0', '9'));
+		return either(ret, equal(vec, splat('_')));
+	}
+
+	vector space(vector vec) {
+		return either(in_range(vec, '\t', '\r'), equal(vec, splat(' ')));
+	}
+
+	vector digit(vector vec) {
+		return in_range(vec, '0', '9');
+	}
+
+	// Scans whole vectors while every byte matches `classify`, finishing any remainder with the table.
+	template<typename F>
+	size_t span_simd(std::string_view view, uint8_t classes, F classify) {
+		size_t i = 0;
+
+		for (; i + WIDTH <= view.length(); i += WIDTH) {
+			auto matches = movemask(classify(load(view.data() + i)));
+
+			if (matches != ALL)
+				return i + __builtin_ctz(~matches);
+		}
+
+		return i + lexer::span(view.substr(i), classes);
+	}
+#endif
+
+#if !defined(KN_LEXER_SCALAR) && defined(__SSE4_1__)
+	// Returns the value of the 16 digits at `digits`, by combining adjacent pairs of digits, then pairs of those, and
+	// so on, with multiply-adds.
+	uint64_t parse_16_digits(char const* digits) {
+		auto vec = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(digits)), _mm_set1_epi8('0'));
+		auto twos = _mm_maddubs_epi16(vec, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+		auto fours = _mm_madd_epi16(twos, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+		auto packed = _mm_packus_epi32(fours, fours);
+		auto eights = _mm_madd_epi16(packed, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(eights)) * uint64_t(100'000'000)
+			+ static_cast<uint32_t>(_mm_extract_epi32(eights, 1));
+	}
+# define KN_LEXER_SIMD_DIGITS
+#endif
+}
+
+size_t lexer::span_whitespace(std::string_view view) noexcept {
+#ifdef KN_LEXER_SIMD
+	// most runs of whitespace are a single space, which isn't worth loading a vector for.
+	if (view.length() < 2 || !is(view[1], WHITESPACE))
+		return span(view.substr(0, 1), WHITESPACE);
+
+	return span_simd(view, WHITESPACE, whitespace);
+#else
+	return span(view, WHITESPACE);
+#endif
+}
+
+size_t lexer::span_identifier(std::string_view view) noexcept {
+#ifdef KN_LEXER_SIMD
+	return span_simd(view, IDENTIFIER, identifier);
+#else
+	return span(view, IDENTIFIER);
+#endif
+}
+
+size_t lexer::span_space(std::string_view view) noexcept {
+#ifdef KN_LEXER_SIMD
+	return span_simd(view, SPACE, space);
+#else
+	return span(view, SPACE);
+#endif
+}
+
+size_t lexer::span_digits(std::string_view view) noexcept {
+#ifdef KN_LEXER_SIMD
+	return span_simd(view, DIGIT, digit);
+#else
+	return span(view, DIGIT);
+#endif
+}
+
+uint64_t lexer::parse_digits(std::string_view digits) noexcept {
+	uint64_t ret = 0;
+
+#ifdef KN_LEXER_SIMD_DIGITS
+	constexpr uint64_t POW10_16 = 10'000'000'000'000'000;
+
+	for (; digits.length() >= 16; digits.remove_prefix(16))
+		ret = ret * POW10_16 + parse_16_digits(digits.data());
+
+	// longer remainders are padded out to 16 digits with leading zeros; shorter ones are quicker to do one at a time.
+	if (digits.length() >= 8) {
+		char padded[16];
+		std::memset(padded, '0', sizeof(padded));
+		std::memcpy(padded + sizeof(padded) - digits.length(), digits.data(), digits.length());
+
+		uint64_t scale = 1;
+		for (size_t i = 0; i < digits.length(); ++i)
+			scale *= 10;
+
+		return ret * scale + parse_16_digits(padded);
+	}
+#endif
+
+	for (auto digit : digits)
+		ret = ret * 10 + static_cast<uint64_t>(digit - '0');
+
+	return ret;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace kn {
+	// Helpers for scanning Knight source code, which are used by the parsers and when converting strings to numbers.
+	//
+	// Characters are classified through a single 256-entry table rather than the locale-aware `<cctype>` functions,
+	// and runs of whitespace, identifier characters and digits are scanned with SSE2 or AVX2 when they're available.
+	// Runs of digits are converted 16 at a time with SSE4.1, when that's available.
+	namespace lexer {
+		// The classes a character can belong to; a character may belong to several.
+		enum : uint8_t {
+			// Whitespace, which also includes all forms of parens and `:`.
+			WHITESPACE = 1 << 0,
+
+			// `0` through `9`.
+			DIGIT = 1 << 1,
+
+			// The start of a variable: a lowercase letter or `_`.
+			IDENTIFIER_START = 1 << 2,
+
+			// The rest of a variable: a lowercase letter, `_`, or a digit.
+			IDENTIFIER = 1 << 3,
+
+			// The rest of a keyword function: an uppercase letter or `_`.
+			KEYWORD = 1 << 4,
+
+			// What `std::isspace` considers whitespace, which is skipped when converting strings to numbers. Unlike
+			// `WHITESPACE`, this doesn't include parens or `:`.
+			SPACE = 1 << 5
+		};
+
+		inline constexpr std::array<uint8_t, 256> CLASSES = [] {
+			std::array<uint8_t, 256> classes {};
+
+			for (auto c : std::string_view(" \t\n\r\v\f()[]{}:"))
+				classes[static_cast<uint8_t>(c)] |= WHITESPACE;
+
+			for (auto c : std::string_view(" \t\n\r\v\f"))
+				classes[static_cast<uint8_t>(c)] |= SPACE;
+
+			for (int c = '0'; c <= '9'; ++c)
+				classes[c] |= DIGIT | IDENTIFIER;
+
+			for (int c = 'a'; c <= 'z'; ++c)
+				classes[c] |= IDENTIFIER_START | IDENTIFIER;
+
+			for (int c = 'A'; c <= 'Z'; ++c)
+				classes[c] |= KEYWORD;
+
+			classes['_'] |= IDENTIFIER_START | IDENTIFIER | KEYWORD;
+
+			return classes;
+		}();
+
+		// Checks whether `c` belongs to any of `classes`.
+		inline bool is(char c, uint8_t classes) noexcept {
+			return CLASSES[static_cast<uint8_t>(c)] & classes;
+		}
+
+		// Returns the length of the run of characters at the start of `view` that belong to `classes`.
+		inline size_t span(std::string_view view, uint8_t classes) noexcept {
+			size_t i = 0;
+
+			while (i < view.length() && is(view[i], classes))
+				++i;
+
+			return i;
+		}
+
+		// Returns the length of the run of whitespace at the start of `view`.
+		size_t span_whitespace(std::string_view view) noexcept;
+
+		// Returns the length of the run of identifier characters at the start of `view`.
+		size_t span_identifier(std::string_view view) noexcept;
+
+		// Returns the length of the run of `SPACE`s at the start of `view`.
+		size_t span_space(std::string_view view) noexcept;
+
+		// Returns the length of the run of digits at the start of `view`.
+		size_t span_digits(std::string_view view) noexcept;
+
+		// Returns the value of `digits`, which must all be digits. This wraps around if it doesn't fit.
+		uint64_t parse_digits(std::string_view digits) noexcept;
+
+		// Returns the length of the comment body at the start of `view`, up to (but not including) the newline.
+		inline size_t span_comment(std::string_view view) noexcept {
+			// `find` uses `memchr`, which is already vectorized.
+			auto newline = view.find('\n');
+
+			return newline == std::string_view::npos ? view.length() : newline;
+		}
+	}
+}
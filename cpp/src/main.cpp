@@ -1,35 +1,224 @@
 #include "knight.hpp"
+#include "interpreter.hpp"
+#include "batch.hpp"
+#include "server.hpp"
+#include "source.hpp"
+#include "precompiled.hpp"
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <charconv>
+#include <optional>
+#include <deque>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
 
 using namespace kn;
 
 void usage(char const* program) {
-	std::cerr << "usage: " << program << " (-e 'expression' | -f file)" << std::endl;
+	std::cerr << "usage: " << program << " [options] (-e 'expression' | -f file | -c file.knc | -b file... | -s [socket])\n"
+		"options: --engine=tree|vm --eval-cache=size --fold --no-fuse --jit --output=line|block|full --stats --compile out.knc "
+		"--jobs=count" << std::endl;
 	exit(1);
 }
 
+namespace {
+	// The options that configure each interpreter.
+	struct Settings {
+		Engine engine = Engine::Tree;
+		size_t eval_cache = EvalCache::DEFAULT_CAPACITY;
+		bool fold = false;
+		bool fuse = true;
+		bool jit = false;
+		std::optional<Output::Policy> output;
+
+		void apply(Interpreter& interpreter) const {
+			interpreter.engine = engine;
+			interpreter.eval_cache.set_capacity(eval_cache);
+			interpreter.constant_folder.enable(fold);
+			interpreter.fuser.enable(fuse);
+			interpreter.jit.enable(jit);
+
+			if (output)
+				interpreter.output.set_policy(*output);
+		}
+	};
+}
+
+// Writes the counters of each of the interpreter's subsystems to stderr.
+static void dump_stats(Interpreter const& interpreter) {
+	interpreter.eval_cache.dump_stats(std::cerr);
+	interpreter.constant_folder.dump_stats(std::cerr);
+	interpreter.fuser.dump_stats(std::cerr);
+	interpreter.jit.dump_stats(std::cerr);
+	interpreter.output.dump_stats(std::cerr);
+
+#ifdef KN_REFCOUNT_STATS
+	std::cerr << "refcounts: " << RefcountStats::increments << " increments, " << RefcountStats::decrements
+		<< " decrements" << std::endl;
+#endif
+}
+
+// Parses the value of a `--option=size` flag, exiting with the usage if it's not a valid size.
+static size_t parse_size(std::string_view value, char const* program) {
+	size_t size;
+	auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), size);
+
+	if (error != std::errc() || end != value.data() + value.size() || value.empty())
+		usage(program);
+
+	return size;
+}
+
+// Writes `contents` to the file at `path`, replacing it.
+static void write_file(char const* path, std::string const& contents) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(contents.data(), contents.size());
+
+	if (!file)
+		throw Error(std::string("unable to write '") + path + "'");
+}
+
+// Runs each of `paths` as an independent program on `jobs` threads, printing their outputs in order.
+//
+// Returns the largest status that any of the programs exited with.
+static int run_files(char** paths, size_t count, Settings const& settings, size_t jobs, bool stats) {
+	std::deque<SourceFile> files;
+	std::vector<std::string_view> sources;
+
+	try {
+		for (size_t i = 0; i < count; ++i)
+			sources.push_back(files.emplace_back(paths[i]).view());
+	} catch (std::exception& err) {
+		std::cerr << "error with your code: " << err.what() << std::endl;
+		return 1;
+	}
+
+	size_t steals;
+	auto results = run_batch(sources, jobs, [&](Interpreter& interpreter) { settings.apply(interpreter); }, &steals);
+
+	Output output(STDOUT_FILENO);
+	int status = 0;
+
+	for (size_t i = 0; i < results.size(); ++i) {
+		output.write(results[i].output);
+
+		if (!results[i].error.empty()) {
+			output.flush();
+			std::cerr << "error with " << paths[i] << ": " << results[i].error << std::endl;
+		}
+
+		status = std::max(status, results[i].status);
+	}
+
+	if (stats)
+		std::cerr << "batch: " << results.size() << " programs, " << steals << " steals" << std::endl;
+
+	return status;
+}
+
 int main(int argc, char **argv) {
-	if (argc != 3) {
+	int argi = 1;
+	Settings settings;
+	bool stats = false;
+	size_t jobs = 0;
+
+	// if set, the program is compiled to this path instead of being run.
+	char const* compile_path = nullptr;
+
+	for (; argi < argc && std::string_view(argv[argi]).rfind("--", 0) == 0; ++argi) {
+		std::string_view option(argv[argi]);
+
+		if (option == "--engine=tree")
+			settings.engine = Engine::Tree;
+		else if (option == "--engine=vm")
+			settings.engine = Engine::Vm;
+		else if (option.rfind("--eval-cache=", 0) == 0)
+			settings.eval_cache = parse_size(option.substr(option.find('=') + 1), argv[0]);
+		else if (option == "--fold")
+			settings.fold = true;
+		else if (option == "--no-fuse")
+			settings.fuse = false;
+		else if (option == "--jit")
+			settings.jit = true;
+		else if (option == "--output=line")
+			settings.output = Output::Policy::Line;
+		else if (option == "--output=block")
+			settings.output = Output::Policy::Block;
+		else if (option == "--output=full")
+			settings.output = Output::Policy::Full;
+		else if (option == "--stats")
+			stats = true;
+		else if (option == "--compile" && argi + 1 < argc)
+			compile_path = argv[++argi];
+		else if (option.rfind("--jobs=", 0) == 0)
+			jobs = parse_size(option.substr(option.find('=') + 1), argv[0]);
+		else
+			usage(argv[0]);
+	}
+
+	if (argi + 1 < argc && std::string_view(argv[argi]) == "-b" && compile_path == nullptr)
+		return run_files(argv + argi + 1, argc - argi - 1, settings, jobs, stats);
+
+	if (argi < argc && std::string_view(argv[argi]) == "-s" && argc - argi <= 2 && compile_path == nullptr) {
+		Server server([settings](Interpreter& interpreter) { settings.apply(interpreter); });
+
+		try {
+			if (argi + 1 < argc)
+				server.listen(argv[argi + 1], jobs);
+			else
+				server.serve(STDIN_FILENO, STDOUT_FILENO);
+		} catch (std::exception& err) {
+			std::cerr << "error with the server: " << err.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (argc - argi != 2) {
 		usage(argv[0]);
 	}
 
-	initialize();
+	Interpreter interpreter(std::cin, STDOUT_FILENO);
+	Interpreter::Scope scope(interpreter);
+	settings.apply(interpreter);
+
+	int status = 0;
 
 	try {
-		if (std::string_view("-e") == argv[1])  {
-			run(argv[2]);
-		} else if (std::string_view("-f") == argv[1]) {
-			std::ifstream file(argv[2]);
-			std::ostringstream contents;
-			contents << file.rdbuf();
-			run(contents.str());
+		std::string_view mode(argv[argi]);
+		Value program;
+
+		if (mode == "-e")  {
+			program = parse(argv[argi + 1]);
+		} else if (mode == "-f") {
+			SourceFile file(argv[argi + 1]);
+			program = parse(file.view());
+		} else if (mode == "-c") {
+			SourceFile file(argv[argi + 1]);
+			program = Precompiled::deserialize(file.view());
+			interpreter.optimize(program);
 		} else {
 			usage(argv[0]);
 		}
+
+		if (compile_path != nullptr)
+			write_file(compile_path, Precompiled::serialize(program));
+		else
+			execute(program);
+	} catch (Quit const& quit) {
+		status = quit.status;
 	} catch (std::exception& err) {
+		interpreter.output.flush();
 		std::cerr << "error with your code: " << err.what() << std::endl;
-		return 1;
+		status = 1;
 	}
+
+	interpreter.output.flush();
+
+	if (stats)
+		dump_stats(interpreter);
+
+	return status;
 }
@@ -0,0 +1,74 @@
+#include "output.hpp"
+#include <unistd.h>
+#include <utility>
+#include <cerrno>
+
+using namespace kn;
+
+Output::Output(int fd, size_t capacity)
+	: fd(fd), policy_(isatty(fd) ? Policy::Line : Policy::Block), capacity_(capacity)
+{
+	buffer.reserve(capacity_);
+}
+
+Output::Output() : fd(-1), policy_(Policy::Full), capacity_(0) {}
+
+Output::~Output() {
+	flush();
+}
+
+void Output::write_all(std::string_view data) noexcept {
+	if (fd < 0) {
+		captured_.append(data);
+		bytes_ += data.size();
+		return;
+	}
+
+	while (!data.empty()) {
+		auto written = ::write(fd, data.data(), data.size());
+		++syscalls_;
+
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+
+			// like stdio, there's nothing sensible to do when stdout is gone, so the output is just discarded.
+			return;
+		}
+
+		bytes_ += written;
+		data.remove_prefix(written);
+	}
+}
+
+void Output::write(std::string_view data) {
+	if (policy_ != Policy::Full && capacity_ < buffer.size() + data.size()) {
+		flush();
+
+		// writes that wouldn't fit in an empty buffer aren't worth copying into it.
+		if (capacity_ <= data.size()) {
+			write_all(data);
+			return;
+		}
+	}
+
+	buffer.append(data);
+
+	if (policy_ == Policy::Line && data.find('\n') != std::string_view::npos)
+		flush();
+}
+
+void Output::flush() noexcept {
+	write_all(buffer);
+	buffer.clear();
+}
+
+std::string Output::take_captured() {
+	flush();
+
+	return std::exchange(captured_, std::string());
+}
+
+std::ostream& Output::dump_stats(std::ostream& out) const {
+	return out << "output: " << bytes_ << " bytes written in " << syscalls_ << " syscalls" << std::endl;
+}
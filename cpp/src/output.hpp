@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstddef>
+
+namespace kn {
+	// A buffered writer for a file descriptor, which is used for everything a Knight program writes to stdout.
+	//
+	// Writes are collected in a user-space buffer and written out with `write(2)`, as dictated by the `Policy`. The
+	// buffer is also flushed whenever something outside of Knight might observe it: at exit, on `QUIT`, before
+	// `PROMPT` reads input, and before `` ` `` runs a command.
+	//
+	// Outputs can also capture what's written to them in memory instead, for programs whose output is returned to
+	// their caller rather than printed.
+	class Output {
+	public:
+		// When the buffer is written out.
+		enum class Policy {
+			// After every write that contains a newline (and when the buffer is full).
+			Line,
+
+			// Only when the buffer is full.
+			Block,
+
+			// Never, until it's explicitly flushed; the buffer grows as needed.
+			Full
+		};
+
+		// The default size of the buffer.
+		static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+	private:
+		// The file descriptor that's written to, or `-1` if the output is captured.
+		int fd;
+		Policy policy_;
+		size_t capacity_;
+		std::string buffer;
+
+		// Everything that's been flushed from a captured output.
+		std::string captured_;
+
+		// The amount of bytes written, and the amount of `write(2)` calls used to do so.
+		size_t bytes_ = 0;
+		size_t syscalls_ = 0;
+
+		// Writes all of `data` directly to `fd`, or to `captured_` if the output is captured.
+		void write_all(std::string_view data) noexcept;
+
+	public:
+		// Creates an output for `fd`, which is line buffered if `fd` is a terminal, and block buffered otherwise.
+		explicit Output(int fd, size_t capacity = DEFAULT_CAPACITY);
+
+		// Creates an output that captures everything written to it; it's only flushed explicitly.
+		Output();
+
+		// Flushes any remaining output.
+		~Output();
+
+		Output(Output const&) = delete;
+		Output& operator=(Output const&) = delete;
+
+		Policy policy() const noexcept { return policy_; }
+		void set_policy(Policy policy) noexcept { policy_ = policy; }
+
+		size_t bytes() const noexcept { return bytes_; }
+		size_t syscalls() const noexcept { return syscalls_; }
+
+		// Writes `data`, flushing as required by the policy.
+		void write(std::string_view data);
+
+		// Writes out everything that's buffered.
+		void flush() noexcept;
+
+		// Flushes the output, and returns everything it's captured so far, leaving it empty.
+		std::string take_captured();
+
+		// Writes the output's counters to `out`.
+		std::ostream& dump_stats(std::ostream& out) const;
+	};
+}
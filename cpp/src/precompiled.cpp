@@ -0,0 +1,276 @@
+#include "precompiled.hpp"
+#include "function.hpp"
+#include "variable.hpp"
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+using namespace kn;
+
+// The bytes every precompiled file starts with.
+static constexpr char MAGIC[4] = { 'K', 'N', 'C', '\0' };
+
+// The magic bytes, version, payload length, and checksum.
+static constexpr size_t HEADER_LENGTH = sizeof(MAGIC) + 4 + 8 + 8;
+
+// How each value within the payload starts.
+enum Tag : uint8_t {
+	TAG_NULL,
+	TAG_TRUE,
+	TAG_FALSE,
+	TAG_NUMBER,   // followed by a 64-bit number
+	TAG_STRING,   // followed by a 32-bit length, and then the bytes
+	TAG_VARIABLE, // followed by a 32-bit index into the variable table
+	TAG_FUNCTION  // followed by the function's name, and then its arguments
+};
+
+static uint64_t checksum(std::string_view bytes) noexcept {
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for (auto byte : bytes) {
+		hash ^= static_cast<uint8_t>(byte);
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+namespace {
+	// Appends little-endian integers and raw bytes to a string.
+	struct Writer {
+		std::string out;
+
+		void u8(uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+		void u32(uint32_t value) {
+			for (int i = 0; i < 4; ++i)
+				u8(static_cast<uint8_t>(value >> (8 * i)));
+		}
+
+		void u64(uint64_t value) {
+			for (int i = 0; i < 8; ++i)
+				u8(static_cast<uint8_t>(value >> (8 * i)));
+		}
+
+		void bytes(std::string_view value) {
+			u32(static_cast<uint32_t>(value.length()));
+			out.append(value);
+		}
+	};
+
+	// Reads what `Writer` writes, throwing an `Error` if the input ends early.
+	struct Reader {
+		std::string_view in;
+
+		void need(size_t amount) {
+			if (in.length() < amount)
+				throw Error("invalid precompiled file: unexpected end of data");
+		}
+
+		uint8_t u8() {
+			need(1);
+			auto value = static_cast<uint8_t>(in.front());
+			in.remove_prefix(1);
+			return value;
+		}
+
+		uint32_t u32() {
+			uint32_t value = 0;
+
+			for (int i = 0; i < 4; ++i)
+				value |= static_cast<uint32_t>(u8()) << (8 * i);
+
+			return value;
+		}
+
+		uint64_t u64() {
+			uint64_t value = 0;
+
+			for (int i = 0; i < 8; ++i)
+				value |= static_cast<uint64_t>(u8()) << (8 * i);
+
+			return value;
+		}
+
+		std::string_view bytes() {
+			auto length = u32();
+			need(length);
+
+			auto value = in.substr(0, length);
+			in.remove_prefix(length);
+			return value;
+		}
+	};
+}
+
+std::string Precompiled::serialize(Value const& program) {
+	Writer values;
+	std::unordered_map<slot_t, uint32_t> variables;
+	std::vector<slot_t> names;
+
+	// values are written in prefix order, with an explicit stack so that deep programs can't overflow.
+	std::vector<Value const*> pending { &program };
+
+	while (!pending.empty()) {
+		auto& value = *pending.back();
+		pending.pop_back();
+
+		if (value.is_null()) {
+			values.u8(TAG_NULL);
+		} else if (value.is_boolean()) {
+			values.u8(Value(value).to_boolean() ? TAG_TRUE : TAG_FALSE);
+		} else if (value.is_number()) {
+			values.u8(TAG_NUMBER);
+			values.u64(static_cast<uint64_t>(value.as_number()));
+		} else if (value.is_string()) {
+			values.u8(TAG_STRING);
+			values.bytes(value.as_string()->view());
+		} else if (value.is_variable()) {
+			auto [index, inserted] = variables.emplace(value.as_variable(), static_cast<uint32_t>(names.size()));
+
+			if (inserted)
+				names.push_back(value.as_variable());
+
+			values.u8(TAG_VARIABLE);
+			values.u32(index->second);
+		} else {
+			auto func = value.as_function();
+			values.u8(TAG_FUNCTION);
+			values.u8(static_cast<uint8_t>(func->name()));
+
+			// push the arguments in reverse, so that they're popped in order.
+			for (auto i = func->arity(); i != 0; --i)
+				pending.push_back(&func->args()[i - 1]);
+		}
+	}
+
+	Writer payload;
+	payload.u32(static_cast<uint32_t>(names.size()));
+
+	for (auto slot : names)
+		payload.bytes(Variable::name(slot));
+
+	payload.out += values.out;
+
+	Writer file;
+	file.out.append(MAGIC, sizeof(MAGIC));
+	file.u32(VERSION);
+	file.u64(payload.out.length());
+	file.u64(checksum(payload.out));
+	file.out += payload.out;
+
+	return std::move(file.out);
+}
+
+Value Precompiled::deserialize(std::string_view bytes) {
+	if (bytes.length() < HEADER_LENGTH || std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) != 0)
+		throw Error("invalid precompiled file: bad magic");
+
+	Reader header { bytes.substr(sizeof(MAGIC), HEADER_LENGTH - sizeof(MAGIC)) };
+	auto version = header.u32();
+	auto length = header.u64();
+	auto expected = header.u64();
+
+	if (version != VERSION)
+		throw Error("invalid precompiled file: unsupported version " + std::to_string(version));
+
+	if (length != bytes.length() - HEADER_LENGTH)
+		throw Error("invalid precompiled file: wrong length");
+
+	Reader reader { bytes.substr(HEADER_LENGTH) };
+
+	if (checksum(reader.in) != expected)
+		throw Error("invalid precompiled file: checksum mismatch");
+
+	// each name takes at least four bytes (its length), so this bounds the allocation by the size of the file.
+	auto count = reader.u32();
+
+	if (reader.in.length() / 4 < count)
+		throw Error("invalid precompiled file: too many variables");
+
+	std::vector<slot_t> slots(count);
+
+	for (auto& slot : slots)
+		slot = Variable::lookup(reader.bytes());
+
+	auto arena = Arena::create(reader.in.length());
+
+	// like `Value::parse`, functions wait on a stack until all their arguments have been read.
+	struct Pending {
+		Value func;
+		uint32_t next;
+	};
+
+	std::vector<Pending> pending;
+
+	for (;;) {
+		Value value;
+		auto tag = reader.u8();
+
+		switch (tag) {
+		case TAG_NULL:
+			break;
+
+		case TAG_TRUE:
+		case TAG_FALSE:
+			value = Value(tag == TAG_TRUE);
+			break;
+
+		case TAG_NUMBER:
+			value = Value(static_cast<number>(reader.u64()));
+			break;
+
+		case TAG_STRING:
+			value = Value(String::create(reader.bytes()));
+			break;
+
+		case TAG_VARIABLE: {
+			auto index = reader.u32();
+
+			if (slots.size() <= index)
+				throw Error("invalid precompiled file: unknown variable");
+
+			value = Value::variable(slots[index]);
+			break;
+		}
+
+		case TAG_FUNCTION: {
+			auto func = Function::create(static_cast<char>(reader.u8()), *arena);
+
+			if (!func)
+				throw Error("invalid precompiled file: unknown function");
+
+			value = std::move(*func);
+
+			if (value.as_function()->arity() != 0) {
+				pending.push_back(Pending { std::move(value), 0 });
+				continue;
+			}
+
+			break;
+		}
+
+		default:
+			throw Error("invalid precompiled file: unknown tag");
+		}
+
+		for (;;) {
+			if (pending.empty()) {
+				if (!reader.in.empty())
+					throw Error("invalid precompiled file: trailing data");
+
+				return value;
+			}
+
+			auto& top = pending.back();
+			auto func = top.func.as_function();
+			func->set_arg(top.next++, std::move(value));
+
+			if (top.next != func->arity())
+				break;
+
+			value = std::move(top.func);
+			pending.pop_back();
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "value.hpp"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace kn {
+	// A compact binary encoding of parsed programs, so that they can be loaded without being parsed again.
+	//
+	// The encoding is position independent: it starts with a header of the magic bytes `KNC\0`, the format `VERSION`,
+	// the length of the payload, and an FNV-1a checksum of the payload, all little-endian. The payload is the table of
+	// variable names, followed by the program's values in prefix order; functions are stored as just their name, with
+	// their arguments following them.
+	class Precompiled {
+	public:
+		// The version of the format, which must be bumped whenever the encoding changes.
+		static constexpr uint32_t VERSION = 1;
+
+		// Encodes `program`.
+		static std::string serialize(Value const& program);
+
+		// Decodes a program that was encoded by `serialize`, allocating its functions within a new arena.
+		//
+		// Throws an `Error` if `bytes` aren't a valid encoding for this version, or their checksum doesn't match.
+		static Value deserialize(std::string_view bytes);
+	};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <utility>
+#include <cstddef>
+
+namespace kn {
+	// Counts the reference count operations done by this thread, which `--stats` reports.
+	//
+	// They're only counted when built with `KN_REFCOUNT_STATS` (ie `make REFCOUNT_STATS=1`), as otherwise every copy
+	// of a string or block would pay for it.
+	struct RefcountStats {
+		static inline thread_local size_t increments = 0;
+		static inline thread_local size_t decrements = 0;
+
+		static void incref() noexcept {
+#ifdef KN_REFCOUNT_STATS
+			++increments;
+#endif
+		}
+
+		static void decref() noexcept {
+#ifdef KN_REFCOUNT_STATS
+			++decrements;
+#endif
+		}
+	};
+
+	// An owning pointer to an intrusively reference-counted `T`.
+	//
+	// `T` must have `incref()` and `decref()` methods; `decref()` is in charge of freeing the object once the last
+	// reference to it is gone. Unlike `std::shared_ptr`, the counts are not atomic.
+	template<typename T>
+	class Ref {
+		T* ptr;
+
+	public:
+		// Takes ownership of one reference to `ptr`, which must not be `nullptr`.
+		explicit Ref(T* ptr) noexcept : ptr(ptr) {}
+
+		// Creates a new reference to `obj`.
+		static Ref share(T& obj) noexcept {
+			obj.incref();
+			return Ref(&obj);
+		}
+
+		Ref(Ref const& rhs) noexcept : ptr(rhs.ptr) { ptr->incref(); }
+		Ref(Ref&& rhs) noexcept : ptr(rhs.ptr) { rhs.ptr = nullptr; }
+
+		Ref& operator=(Ref rhs) noexcept {
+			std::swap(ptr, rhs.ptr);
+			return *this;
+		}
+
+		~Ref() {
+			if (ptr)
+				ptr->decref();
+		}
+
+		// Gives up ownership of the reference, returning the pointer.
+		T* release() noexcept { return std::exchange(ptr, nullptr); }
+
+		T* get() const noexcept { return ptr; }
+		T& operator*() const noexcept { return *ptr; }
+		T* operator->() const noexcept { return ptr; }
+	};
+}
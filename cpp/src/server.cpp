@@ -0,0 +1,174 @@
+#include "server.hpp"
+#include "batch.hpp"
+#include "thread_pool.hpp"
+#include "knight.hpp"
+#include <future>
+#include <sstream>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <iostream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace kn;
+
+// Throws an `Error` describing the last failed system call.
+[[noreturn]] static void fail(char const* what) {
+	throw Error(std::string(what) + ": " + std::strerror(errno));
+}
+
+// Reads exactly `length` bytes into `data`. Returns false if `fd` was closed before anything was read.
+static bool read_exact(int fd, char* data, size_t length) {
+	size_t total = 0;
+
+	while (total < length) {
+		auto amount = ::read(fd, data + total, length - total);
+
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+
+			fail("unable to read request");
+		}
+
+		if (amount == 0) {
+			if (total == 0)
+				return false;
+
+			throw Error("truncated request");
+		}
+
+		total += amount;
+	}
+
+	return true;
+}
+
+static void write_all(int fd, std::string_view data) {
+	while (!data.empty()) {
+		auto amount = ::write(fd, data.data(), data.size());
+
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+
+			fail("unable to write response");
+		}
+
+		data.remove_prefix(amount);
+	}
+}
+
+// Appends `value` to `out` as a little-endian integer of `Bytes` bytes.
+template<size_t Bytes>
+static void put(std::string& out, uint64_t value) {
+	for (size_t i = 0; i < Bytes; ++i)
+		out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+static void put_bytes(std::string& out, std::string_view bytes) {
+	put<4>(out, bytes.size());
+	out.append(bytes);
+}
+
+void Server::serve(int input, int output, ThreadPool* pool) const {
+	std::string source;
+	std::string response;
+
+	while (true) {
+		unsigned char header[4];
+
+		if (!read_exact(input, reinterpret_cast<char*>(header), sizeof header))
+			return;
+
+		uint32_t length = 0;
+		for (size_t i = 0; i < sizeof header; ++i)
+			length |= static_cast<uint32_t>(header[i]) << (8 * i);
+
+		source.resize(length);
+		if (length != 0 && !read_exact(input, source.data(), length))
+			throw Error("truncated request");
+
+		BatchResult result;
+
+		if (pool == nullptr) {
+			std::istringstream no_input;
+			result = run_isolated(source, no_input, configure);
+		} else {
+			std::promise<BatchResult> promise;
+			auto future = promise.get_future();
+
+			pool->submit([this, &source, &promise] {
+				try {
+					std::istringstream no_input;
+					promise.set_value(run_isolated(source, no_input, configure));
+				} catch (...) {
+					promise.set_exception(std::current_exception());
+				}
+			});
+
+			result = future.get();
+		}
+
+		response.clear();
+		put<4>(response, static_cast<uint32_t>(result.status));
+		put<8>(response, static_cast<uint64_t>(result.elapsed.count()));
+		put_bytes(response, result.output);
+		put_bytes(response, result.error);
+		write_all(output, response);
+	}
+}
+
+void Server::listen(char const* path, size_t threads) const {
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+
+	if (std::strlen(path) >= sizeof address.sun_path)
+		throw Error(std::string("socket path is too long: ") + path);
+
+	std::strcpy(address.sun_path, path);
+
+	int sock = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		fail("unable to create socket");
+
+	::unlink(path);
+
+	if (::bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof address) < 0)
+		fail("unable to bind socket");
+
+	if (::listen(sock, SOMAXCONN) < 0)
+		fail("unable to listen on socket");
+
+	// clients that disconnect early must only end their own connection, not the whole server.
+	std::signal(SIGPIPE, SIG_IGN);
+
+	ThreadPool pool(threads);
+
+	while (true) {
+		int client = ::accept4(sock, nullptr, nullptr, SOCK_CLOEXEC);
+
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			fail("unable to accept connection");
+		}
+
+		// each connection gets its own thread, which only waits on its client; the programs themselves are run on the
+		// pool. (If connections were the pool's tasks, any more clients than threads would wait for others to leave.)
+		std::thread([this, client, &pool] {
+			try {
+				serve(client, client, &pool);
+			} catch (std::exception const& err) {
+				std::cerr << "connection closed: " << err.what() << std::endl;
+			}
+
+			::close(client);
+		}).detach();
+	}
+}
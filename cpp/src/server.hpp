@@ -0,0 +1,46 @@
+#pragma once
+
+#include "interpreter.hpp"
+#include <functional>
+#include <cstddef>
+
+namespace kn {
+	class ThreadPool;
+
+	// A long-running mode that evaluates a stream of programs, so that running many small programs doesn't pay for
+	// starting a process for each one.
+	//
+	// Every program runs in a fresh interpreter (and so with no variables), with its output captured and no input.
+	// All integers are little-endian, as in precompiled files. Each request is a single program:
+	//
+	//     u32 length, followed by `length` bytes of source code
+	//
+	// And each request is answered, in order, by:
+	//
+	//     u32 status           zero, the status passed to `QUIT`, or one if the program raised an error
+	//     u64 nanoseconds      how long parsing and running the program took
+	//     u32 length, bytes    everything the program wrote to its output
+	//     u32 length, bytes    the error's message, or nothing if it didn't raise one
+	//
+	// A connection ends once its client closes it, after any remaining requests are answered.
+	class Server {
+		std::function<void(Interpreter&)> configure;
+
+	public:
+		// Creates a server whose interpreters are each passed to `configure` before they run their program.
+		explicit Server(std::function<void(Interpreter&)> configure) : configure(std::move(configure)) {}
+
+		// Answers the requests read from `input` on `output`, until `input` is closed. Programs are run on `pool` if
+		// it's given, and on the calling thread otherwise.
+		//
+		// Throws an `Error` if a request is truncated, or a response can't be written.
+		void serve(int input, int output, ThreadPool* pool = nullptr) const;
+
+		// Listens on the Unix-domain socket at `path`, serving each connection to it on its own thread, and running
+		// their programs on a pool of `threads` threads (zero uses one per hardware thread). Any existing file at
+		// `path` is replaced.
+		//
+		// This only returns by throwing an `Error`, if the socket can't be set up.
+		[[noreturn]] void listen(char const* path, size_t threads) const;
+	};
+}
@@ -0,0 +1,70 @@
+#include "source.hpp"
+#include "error.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+using namespace kn;
+
+namespace {
+	// Closes a file descriptor when it goes out of scope.
+	struct FileDescriptor {
+		int fd;
+
+		~FileDescriptor() {
+			if (fd >= 0)
+				close(fd);
+		}
+	};
+}
+
+SourceFile::SourceFile(char const* path) {
+	FileDescriptor file { open(path, O_RDONLY) };
+
+	if (file.fd < 0)
+		throw Error(std::string("unable to open '") + path + "': " + std::strerror(errno));
+
+	struct stat info;
+
+	if (fstat(file.fd, &info) == 0 && S_ISREG(info.st_mode)) {
+		// empty files can't be mapped, but there's nothing to read anyways.
+		if (info.st_size == 0)
+			return;
+
+		auto result = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+
+		if (result != MAP_FAILED) {
+			madvise(result, info.st_size, MADV_SEQUENTIAL);
+			mapping = result;
+			length = info.st_size;
+			return;
+		}
+	}
+
+	// pipes and the like are just read until they're exhausted.
+	char chunk[64 * 1024];
+
+	for (;;) {
+		auto amount = read(file.fd, chunk, sizeof(chunk));
+
+		if (amount == 0)
+			break;
+
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+
+			throw Error(std::string("unable to read '") + path + "': " + std::strerror(errno));
+		}
+
+		buffer.append(chunk, amount);
+	}
+}
+
+SourceFile::~SourceFile() {
+	if (mapping != nullptr)
+		munmap(mapping, length);
+}
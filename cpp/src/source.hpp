@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace kn {
+	// The contents of a source file, which is memory-mapped when possible so that it's parsed without being copied.
+	//
+	// Files that can't be mapped (such as pipes) are instead read into a buffer.
+	class SourceFile {
+		// The mapping, or `nullptr` if the file was read into `buffer` instead.
+		void* mapping = nullptr;
+		size_t length = 0;
+		std::string buffer;
+
+	public:
+		// Loads the file at `path`, throwing an `Error` if it can't be opened or read.
+		explicit SourceFile(char const* path);
+
+		// Unmaps the file, if it was mapped.
+		~SourceFile();
+
+		SourceFile(SourceFile const&) = delete;
+		SourceFile& operator=(SourceFile const&) = delete;
+
+		// The contents of the file, which are only valid for as long as this is alive.
+		std::string_view view() const noexcept {
+			if (mapping == nullptr)
+				return buffer;
+
+			return std::string_view(static_cast<char const*>(mapping), length);
+		}
+	};
+}
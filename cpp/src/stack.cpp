@@ -0,0 +1,29 @@
+#include "stack.hpp"
+#include "error.hpp"
+#include <pthread.h>
+
+using namespace kn;
+
+void NativeStack::prepare() noexcept {
+	if (limit_ != nullptr)
+		return;
+
+#ifdef __linux__
+	pthread_attr_t attr;
+	void* base;
+	size_t size;
+
+	if (pthread_getattr_np(pthread_self(), &attr) != 0)
+		return;
+
+	// stacks grow downwards, so `base` is the lowest address of the stack.
+	if (pthread_attr_getstack(&attr, &base, &size) == 0 && RESERVED < size)
+		limit_ = static_cast<char const*>(base) + RESERVED;
+
+	pthread_attr_destroy(&attr);
+#endif
+}
+
+void NativeStack::overflowed() {
+	throw Error("program is nested too deeply (try --engine=vm)");
+}
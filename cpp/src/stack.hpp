@@ -0,0 +1,31 @@
+#pragma once
+
+namespace kn {
+	// Keeps the tree-walking engine from overflowing the native stack.
+	//
+	// The tree walker recurses once per level of nesting, so deeply nested programs would otherwise crash the whole
+	// process. Instead, `Function::run` checks how much of its thread's stack is left, and raises an `Error` once it
+	// gets close to running out. (The VM doesn't recurse, and so isn't limited by this.)
+	class NativeStack {
+		// The lowest address this thread's stack can reach before running a function raises an error, or `nullptr`
+		// if it hasn't been found yet (or can't be).
+		static inline thread_local char const* limit_ = nullptr;
+
+		[[noreturn]] static void overflowed();
+
+	public:
+		NativeStack() = delete;
+
+		// How much of the stack is kept in reserve, for raising the error and unwinding.
+		static constexpr unsigned long RESERVED = 256 * 1024;
+
+		// Finds the limit of the current thread's stack, if it hasn't been already.
+		static void prepare() noexcept;
+
+		// Raises an `Error` if the stack is nearly exhausted.
+		static void check() {
+			if (static_cast<char const*>(__builtin_frame_address(0)) < limit_)
+				overflowed();
+		}
+	};
+}
@@ -0,0 +1,177 @@
+#include "string.hpp"
+#include "lexer.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace kn;
+
+thread_local String String::EMPTY("", nullptr);
+thread_local String String::NULL_STRING("null", nullptr);
+thread_local String String::TRUE_STRING("true", nullptr);
+thread_local String String::FALSE_STRING("false", nullptr);
+
+// Static strings start with a reference owned by the static itself, so they're never freed.
+String::String(std::string_view str, std::nullptr_t) noexcept
+	: refcount(1), length_(str.length()), ptr(const_cast<char*>(str.data())), kind(Kind::Embedded) {}
+
+String::String(size_t length) : refcount(1), length_(length) {
+	if (length <= EMBED_LENGTH) {
+		ptr = embed;
+		kind = Kind::Embedded;
+	} else {
+		ptr = new char[length];
+		kind = Kind::Allocated;
+	}
+}
+
+String::String(String* lhs, String* rhs) noexcept
+	: refcount(1), length_(lhs->length_ + rhs->length_), ptr(nullptr), rope { lhs, rhs }, kind(Kind::Rope) {}
+
+String::String(String& owner, char const* data, size_t length) noexcept
+	: refcount(1), length_(length), ptr(const_cast<char*>(data)), owner(&owner), kind(Kind::Slice)
+{
+	owner.incref();
+}
+
+// Ropes and slices don't release the strings they refer to here, as that's done without recursion by `destroy`.
+String::~String() {
+	if (kind == Kind::Allocated)
+		delete[] ptr;
+}
+
+void String::destroy() noexcept {
+	// ropes can be arbitrarily deep, so rather than recursively freeing their halves, strings that need to be freed
+	// are linked together through their (now unused) reference counts.
+	auto pending = this;
+	refcount = 0;
+
+	while (pending != nullptr) {
+		auto str = pending;
+		pending = reinterpret_cast<String*>(str->refcount);
+
+		auto release = [&](String* referenced) {
+			RefcountStats::decref();
+
+			if (--referenced->refcount == 0) {
+				referenced->refcount = reinterpret_cast<size_t>(pending);
+				pending = referenced;
+			}
+		};
+
+		if (str->kind == Kind::Rope) {
+			release(str->rope.lhs);
+			release(str->rope.rhs);
+		} else if (str->kind == Kind::Slice) {
+			release(str->owner);
+		}
+
+		delete str;
+	}
+}
+
+void String::flatten() const {
+	auto buffer = new char[length_];
+	auto dst = buffer;
+
+	// walk the leaves from left to right; an explicit stack is used, as ropes can be arbitrarily deep.
+	std::vector<String const*> stack { this };
+
+	while (!stack.empty()) {
+		auto str = stack.back();
+		stack.pop_back();
+
+		if (str->kind == Kind::Rope) {
+			stack.push_back(str->rope.rhs);
+			stack.push_back(str->rope.lhs);
+		} else {
+			std::memcpy(dst, str->ptr, str->length_);
+			dst += str->length_;
+		}
+	}
+
+	auto [lhs, rhs] = rope;
+	ptr = buffer;
+	kind = Kind::Allocated;
+
+	lhs->decref();
+	rhs->decref();
+}
+
+Ref<String> String::alloc(size_t length) {
+	if (length == 0)
+		return Ref<String>::share(EMPTY);
+
+	return Ref<String>(new String(length));
+}
+
+Ref<String> String::create(std::string_view str) {
+	auto ret = alloc(str.length());
+
+	if (!str.empty())
+		std::memcpy(ret->mut_data(), str.data(), str.length());
+
+	return ret;
+}
+
+Ref<String> String::substr(size_t start, size_t length) {
+	if (start == 0 && length == length_)
+		return Ref<String>::share(*this);
+
+	if (length <= EMBED_LENGTH)
+		return create(view().substr(start, length));
+
+	// flatten ropes first, so that the slice can refer to their buffer.
+	auto bytes = data() + start;
+
+	// slices always refer to the string that owns the bytes, so they never form chains.
+	return Ref<String>(new String(kind == Kind::Slice ? *owner : *this, bytes, length));
+}
+
+Ref<String> String::concat(std::string_view lhs, std::string_view rhs) {
+	auto ret = alloc(lhs.length() + rhs.length());
+
+	if (!lhs.empty())
+		std::memcpy(ret->mut_data(), lhs.data(), lhs.length());
+
+	if (!rhs.empty())
+		std::memcpy(ret->mut_data() + lhs.length(), rhs.data(), rhs.length());
+
+	return ret;
+}
+
+Ref<String> String::concat(Ref<String> lhs, Ref<String> rhs) {
+	if (rhs->empty())
+		return lhs;
+
+	if (lhs->empty())
+		return rhs;
+
+	if (lhs->length() + rhs->length() < ROPE_MIN_LENGTH)
+		return concat(lhs->view(), rhs->view());
+
+	return Ref<String>(new String(lhs.release(), rhs.release()));
+}
+
+Ref<String> String::concat(Ref<String> lhs, std::string_view rhs) {
+	if (rhs.empty())
+		return lhs;
+
+	if (lhs->length() + rhs.length() < ROPE_MIN_LENGTH)
+		return concat(lhs->view(), rhs);
+
+	return concat(std::move(lhs), create(rhs));
+}
+
+long long String::parse_number() const {
+	auto str = view();
+	str.remove_prefix(lexer::span_space(str));
+
+	bool negative = !str.empty() && str.front() == '-';
+
+	if (!str.empty() && (str.front() == '-' || str.front() == '+'))
+		str.remove_prefix(1);
+
+	auto magnitude = lexer::parse_digits(str.substr(0, lexer::span_digits(str)));
+
+	return static_cast<long long>(negative ? 0 - magnitude : magnitude);
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "ref.hpp"
+#include <string_view>
+#include <ostream>
+#include <cstdint>
+
+namespace kn {
+	// The string type within Knight.
+	//
+	// Strings are immutable once created, and are shared through an embedded, non-atomic reference count. Short
+	// strings are stored inline within the struct itself, so creating them only requires a single allocation.
+	//
+	// Concatenating long strings doesn't copy them: instead, a "rope" is created that just refers to both halves, and
+	// its bytes are only copied into a contiguous buffer ("flattened") the first time they're needed. This keeps
+	// building up a string piece by piece linear, rather than quadratic. Likewise, long substrings are "slices" that
+	// refer to the bytes of the string they're taken from, rather than copying them.
+	class String {
+		// The amount of references to this string, which is only changed through `incref` and `decref`.
+		//
+		// While a string is being destroyed, it's instead used to link it to the next string to destroy.
+		size_t refcount;
+
+		// The length of the string, in bytes.
+		size_t length_;
+
+		// A pointer to the string's bytes; either `embed`, an allocated buffer, static data, or the bytes of another
+		// string. This is `nullptr` for ropes that haven't been flattened yet.
+		mutable char* ptr;
+
+	public:
+		// The maximum length of a string that's stored inline.
+		static constexpr size_t EMBED_LENGTH = 23;
+
+		// The minimum length of a concatenation for it to create a rope, rather than just copying both sides.
+		static constexpr size_t ROPE_MIN_LENGTH = 128;
+
+	private:
+		union {
+			// The data for embedded strings.
+			char embed[EMBED_LENGTH];
+
+			// The two halves of a rope, which it owns references to until it's flattened.
+			struct {
+				String* lhs;
+				String* rhs;
+			} rope;
+
+			// The string that owns the bytes of a slice, which it owns a reference to.
+			String* owner;
+		};
+
+		// Where the bytes of a string are stored, and thus what has to be freed along with it.
+		enum class Kind : uint8_t {
+			// In `embed` or static data, so there's nothing to free.
+			Embedded,
+
+			// In a buffer that was allocated by this string.
+			Allocated,
+
+			// In the `rope`'s halves, until it's flattened; flattening it makes it `Allocated`.
+			Rope,
+
+			// In the `owner`'s buffer.
+			Slice
+		};
+
+		mutable Kind kind;
+
+		// Whether `number_` holds the result of converting this string to a number yet.
+		mutable bool has_number = false;
+
+		// The result of converting this string to a number, which can be cached as strings are immutable.
+		mutable long long number_;
+
+		// Creates an uninitialized string of the given length.
+		explicit String(size_t length);
+
+		// Creates a rope of `lhs` followed by `rhs`, taking ownership of both references.
+		String(String* lhs, String* rhs) noexcept;
+
+		// Creates a slice of the `length` bytes at `data`, which are owned by `owner`.
+		String(String& owner, char const* data, size_t length) noexcept;
+
+		bool is_rope() const noexcept { return kind == Kind::Rope; }
+
+		// Copies the bytes of this rope into a contiguous buffer, and releases its halves.
+		void flatten() const;
+
+		// Converts this string to a number, without caching the result.
+		long long parse_number() const;
+
+		// Frees this string, along with any halves of ropes that are no longer referenced.
+		void destroy() noexcept;
+
+		String(String const&) = delete;
+		String& operator=(String const&) = delete;
+
+	public:
+		// Creates a string pointing to the static data `str`; the string itself must be static too.
+		explicit String(std::string_view str, std::nullptr_t) noexcept;
+
+		~String();
+
+		// The shared empty string.
+		//
+		// This and the other static strings are per-thread, as their reference counts aren't atomic.
+		static thread_local String EMPTY;
+
+		// The results of converting null, true, and false to strings.
+		static thread_local String NULL_STRING;
+		static thread_local String TRUE_STRING;
+		static thread_local String FALSE_STRING;
+
+		// Creates a new string that's a copy of `str`.
+		static Ref<String> create(std::string_view str);
+
+		// Allocates a string of `length` bytes, whose contents must then be populated through `mut_data()`.
+		static Ref<String> alloc(size_t length);
+
+		void incref() noexcept {
+			RefcountStats::incref();
+			++refcount;
+		}
+
+		void decref() noexcept {
+			RefcountStats::decref();
+
+			if (--refcount == 0)
+				destroy();
+		}
+
+		size_t length() const noexcept { return length_; }
+		bool empty() const noexcept { return length_ == 0; }
+
+		// Returns the bytes of this string, flattening it first if it's a rope.
+		char const* data() const {
+			if (is_rope())
+				flatten();
+
+			return ptr;
+		}
+
+		std::string_view view() const { return std::string_view(data(), length_); }
+		operator std::string_view() const { return view(); }
+
+		// Converts this string to a number: leading whitespace is skipped, then an optional sign is read, followed by
+		// digits up until the first non-digit. This is only done the first time, after which the result is cached.
+		long long to_number() const {
+			if (!has_number) {
+				number_ = parse_number();
+				has_number = true;
+			}
+
+			return number_;
+		}
+
+		// Returns a mutable pointer to the string's data; only valid for strings fresh from `alloc`.
+		char* mut_data() noexcept { return ptr; }
+
+		// Returns a new string containing `length` bytes starting at `start`, which must be in bounds.
+		//
+		// Substrings longer than `EMBED_LENGTH` are slices that share this string's bytes.
+		Ref<String> substr(size_t start, size_t length);
+
+		// Creates a new string that's `lhs` followed by `rhs`.
+		static Ref<String> concat(std::string_view lhs, std::string_view rhs);
+
+		// Creates a new string that's `lhs` followed by `rhs`, which is a rope if the result is long enough.
+		static Ref<String> concat(Ref<String> lhs, Ref<String> rhs);
+
+		// Like `concat(Ref, Ref)`, but the bytes of `rhs` are only copied into a string of their own for a rope.
+		static Ref<String> concat(Ref<String> lhs, std::string_view rhs);
+	};
+
+	inline std::ostream& operator<<(std::ostream& out, String const& str) {
+		return out << str.view();
+	}
+}
@@ -0,0 +1,96 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+using namespace kn;
+
+ThreadPool::ThreadPool(size_t count) {
+	if (count == 0)
+		count = std::max(1u, std::thread::hardware_concurrency());
+
+	queues.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+		threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void ThreadPool::submit(Task task) {
+	{
+		std::lock_guard lock(mutex);
+		++queued;
+		++pending;
+
+		queues[next].push_back(std::move(task));
+		next = (next + 1) % queues.size();
+	}
+
+	wake.notify_one();
+}
+
+bool ThreadPool::take(size_t index, Task& task) {
+	std::lock_guard lock(mutex);
+
+	// the count changes along with the queues, so a worker woken by a task always finds it rather than spinning.
+	if (queued == 0)
+		return false;
+
+	for (size_t i = 0; i < queues.size(); ++i) {
+		auto& queue = queues[(index + i) % queues.size()];
+
+		if (queue.empty())
+			continue;
+
+		if (i == 0) {
+			task = std::move(queue.back());
+			queue.pop_back();
+		} else {
+			task = std::move(queue.front());
+			queue.pop_front();
+			steals_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		--queued;
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::work(size_t index) {
+	Task task;
+
+	while (true) {
+		if (take(index, task)) {
+			task();
+			task = nullptr;
+
+			std::lock_guard lock(mutex);
+			if (--pending == 0)
+				idle.notify_all();
+
+			continue;
+		}
+
+		std::unique_lock lock(mutex);
+		wake.wait(lock, [&] { return queued != 0 || stopping; });
+
+		if (queued == 0 && stopping)
+			return;
+	}
+}
+
+void ThreadPool::wait() {
+	std::unique_lock lock(mutex);
+	idle.wait(lock, [&] { return pending == 0; });
+}
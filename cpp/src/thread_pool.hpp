@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace kn {
+	// A fixed-size pool of threads that run submitted tasks, balancing them by work stealing.
+	//
+	// Every worker has its own queue: submitted tasks are dealt out to the queues in turn, and each worker runs tasks
+	// from the back of its own queue. Once that's empty, it steals from the front of the others' instead, so one
+	// worker being stuck on a long task doesn't hold up the tasks queued behind it.
+	class ThreadPool {
+		using Task = std::function<void()>;
+
+		std::vector<std::deque<Task>> queues;
+		std::vector<std::thread> threads;
+
+		// Guards the queues and the counts below, which the condition variables wait on. Tasks are long compared to
+		// taking them, so one lock for everything costs little, and keeps `queued` exact.
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable idle;
+
+		// The amount of tasks that are in a queue, and the amount that haven't finished yet.
+		size_t queued = 0;
+		size_t pending = 0;
+
+		// The queue the next submitted task is added to.
+		size_t next = 0;
+		bool stopping = false;
+
+		std::atomic<size_t> steals_ { 0 };
+
+		// Takes a task for the worker `index`, from its own queue if possible; returns whether one was found.
+		bool take(size_t index, Task& task);
+
+		// The loop that each worker thread runs.
+		void work(size_t index);
+
+	public:
+		// Starts `threads` workers; zero uses one per hardware thread.
+		explicit ThreadPool(size_t threads = 0);
+
+		// Finishes all submitted tasks, then stops the workers.
+		~ThreadPool();
+
+		ThreadPool(ThreadPool const&) = delete;
+		ThreadPool& operator=(ThreadPool const&) = delete;
+
+		size_t size() const noexcept { return threads.size(); }
+
+		// The amount of tasks that were run by a worker other than the one they were submitted to.
+		size_t steals() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+		// Queues `task` to be run by one of the workers. Tasks must not throw.
+		void submit(Task task);
+
+		// Blocks until every task that's been submitted has finished.
+		void wait();
+	};
+}
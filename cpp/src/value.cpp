@@ -1,26 +1,114 @@
 #include "value.hpp"
 #include "variable.hpp"
 #include "function.hpp"
+#include "lexer.hpp"
+#include <vector>
+#include <charconv>
 
 using namespace kn;
-using std::make_shared;
-using std::shared_ptr;
 
-Value::Value() noexcept : data(null {}) {}
-Value::Value(bool boolean) noexcept : data(boolean) {}
-Value::Value(number num) noexcept : data(num) {}
-Value::Value(string str) noexcept : Value(make_shared<string>(str)) {}
-Value::Value(shared_ptr<string> str) noexcept : data(str) {}
-Value::Value(shared_ptr<Variable> var) noexcept : data(var) {}
-Value::Value(shared_ptr<Function> func) noexcept : data(func) {}
+/*
+ * The layout of `Value`, which is the same as the C implementation's `kn_value`:
+ * 0...00000 - FALSE
+ * X...XXXX1 - 63-bit signed integer
+ * 0...00010 - NULL
+ * 0...00100 - TRUE
+ * X...X0000 - string (nonzero `X`)
+ * X...X0010 - variable, whose slot is `X` (nonzero `X`)
+ * X...X0100 - function (nonzero `X`)
+ * 0...00110 - undefined (only used for unassigned variables)
+ * note all pointers are 8+-byte-aligned.
+ *
+ * Strings are reference counted directly, whereas functions keep the `Arena` that owns them alive. Variables are just
+ * slots within the global variable table, so they're not reference counted.
+ */
+Value::Value(Ref<String> str) noexcept : data(reinterpret_cast<uint64_t>(str.release()) | TAG_STRING) {}
+
+Value::Value(Function* func) noexcept : data(reinterpret_cast<uint64_t>(func) | TAG_FUNCTION) {
+	incref_function();
+}
+
+void Value::incref_function() const noexcept {
+	as_function()->arena().incref();
+}
+
+void Value::decref_function() const noexcept {
+	as_function()->arena().decref();
+}
+
+std::string_view kn::format_number(number num, char (&buffer)[MAX_NUMBER_LENGTH]) noexcept {
+	auto result = std::to_chars(buffer, buffer + MAX_NUMBER_LENGTH, num);
+
+	return std::string_view(buffer, result.ptr - buffer);
+}
+
+size_t kn::number_length(number num) noexcept {
+	// the magnitude is taken unsigned, so that negating the smallest number doesn't overflow.
+	auto magnitude = num < 0 ? 0 - static_cast<unsigned long long>(num) : static_cast<unsigned long long>(num);
+	size_t length = num < 0 ? 2 : 1;
+
+	for (; magnitude >= 10; magnitude /= 10)
+		++length;
+
+	return length;
+}
 
 static void remove_keyword(std::string_view& view) {
-	do {
-			view.remove_prefix(1);
-	} while (std::isupper(view.front()) || view.front() == '_');
+	view.remove_prefix(1 + lexer::span(view.substr(1), lexer::KEYWORD));
 }
 
 std::optional<Value> Value::parse(std::string_view& view) {
+	auto arena = Arena::create(view.length());
+
+	return parse(view, *arena);
+}
+
+std::optional<Value> Value::parse(std::string_view& view, Arena& arena) {
+	// the functions whose arguments are still being parsed, along with the index of the next one.
+	struct Pending {
+		Value func;
+		uint32_t next;
+	};
+
+	std::vector<Pending> pending;
+
+	for (;;) {
+		auto token = parse_token(view, arena);
+
+		if (!token) {
+			if (pending.empty())
+				return std::nullopt;
+
+			throw Error("Cannot parse function.");
+		}
+
+		auto value = std::move(*token);
+
+		// functions with arguments have to wait until they're all parsed.
+		if (value.is_function() && value.as_function()->arity() != 0) {
+			pending.push_back(Pending { std::move(value), 0 });
+			continue;
+		}
+
+		// otherwise, the value completes the innermost pending function, which may in turn complete its parent.
+		for (;;) {
+			if (pending.empty())
+				return std::make_optional<Value>(std::move(value));
+
+			auto& top = pending.back();
+			auto func = top.func.as_function();
+			func->set_arg(top.next++, std::move(value));
+
+			if (top.next != func->arity())
+				break;
+
+			value = std::move(top.func);
+			pending.pop_back();
+		}
+	}
+}
+
+std::optional<Value> Value::parse_token(std::string_view& view, Arena& arena) {
 	char front;
 
 top:
@@ -30,16 +118,12 @@ top:
 	// note that in knight, all forms of parens and `:` are considered whitespace.
 	switch (front = view.front()) {
 	case '#':
-		do {
-			view.remove_prefix(1);
-		} while (!view.empty() && view.front() != '\n');
-		// fallthrough, as we know the first character is `\n`.
+		view.remove_prefix(lexer::span_comment(view));
+		goto top;
 
 	case ' ': case '\t': case '\n': case '\r': case '\v': case '\f':
 	case '(': case  ')': case  '[': case  ']': case  '{': case  '}': case ':': 
-		do {
-			view.remove_prefix(1);
-		} while (std::isspace(view.front()));
+		view.remove_prefix(lexer::span_whitespace(view));
 		goto top;
 
 	case 'N':
@@ -54,26 +138,23 @@ top:
 	case '\'':
 	case '\"': {
 		view.remove_prefix(1);
-		auto begin = view.cbegin();
+		auto length = view.find(front);
 
-		for(char quote = front; quote != view.front(); view.remove_prefix(1))
-			if (view.empty())
-				throw Error("unmatched quote encountered!");
+		if (length == std::string_view::npos)
+			throw Error("unmatched quote encountered!");
 
-		string ret(begin, view.cbegin());
-		view.remove_prefix(1);
+		auto ret = String::create(view.substr(0, length));
+		view.remove_prefix(length + 1);
 
-		return std::make_optional<Value>(ret);
+		return std::make_optional<Value>(std::move(ret));
 	}
 
 	case '0': case '1': case '2': case '3': case '4':
 	case '5': case '6': case '7': case '8': case '9': {
-		number num = 0;
-
-		for (; std::isdigit(front = view.front()); view.remove_prefix(1)) {
-			num = num * 10 + (front - '0');
-		}
+		auto digits = lexer::span_digits(view);
+		auto num = static_cast<number>(lexer::parse_digits(view.substr(0, digits)));
 
+		view.remove_prefix(digits);
 		return std::make_optional<Value>(num);
 	}
 
@@ -81,7 +162,7 @@ top:
 		if (auto var = Variable::parse(view))
 			return std::make_optional<Value>(*var);
 
-		if (auto func = Function::parse(view))
+		if (auto func = Function::parse(view, arena))
 			return std::make_optional<Value>(*func);
 
 		throw Error("invalid character encountered: " + std::to_string(front));
@@ -89,179 +170,227 @@ top:
 }
 
 
-template <typename... Fns>
-struct overload : Fns... { using Fns::operator()...; };
+bool Value::to_boolean() const {
+	if (is_number())
+		return as_number() != 0;
+
+	switch (data) {
+	case FALSE_:
+	case NULL_:
+		return false;
+	case TRUE_:
+		return true;
+	}
+
+	switch (tag()) {
+	case TAG_STRING:
+		return !as_string()->empty();
+	case TAG_VARIABLE: {
+		Value scratch;
+		return Variable::borrow(as_variable(), scratch).to_boolean();
+	}
+	default:
+		return as_function()->run().to_boolean();
+	}
+}
+
+number Value::to_number() const {
+	if (is_number())
+		return as_number();
 
-template <typename... Fns>
-overload(Fns...) -> overload<Fns...>;
+	switch (data) {
+	case FALSE_:
+	case NULL_:
+		return 0;
+	case TRUE_:
+		return 1;
+	}
 
-bool Value::to_boolean() {
-	return std::visit(overload {
-		[](null) { return false; },
-		[](bool boolean) { return boolean; },
-		[](number num) { return num != 0; },
-		[](shared_ptr<string> const& str) { return str->length() != 0; },
-		[](shared_ptr<Variable> const& var) { return var->run().to_boolean(); },
-		[](shared_ptr<Function> const& func) { return func->run().to_boolean(); }
-	}, data);
+	switch (tag()) {
+	case TAG_STRING:
+		return as_string()->to_number();
+	case TAG_VARIABLE: {
+		Value scratch;
+		return Variable::borrow(as_variable(), scratch).to_number();
+	}
+	default:
+		return as_function()->run().to_number();
+	}
 }
 
-number Value::to_number() {
-	return std::visit(overload {
-		[](null) { return (number) 0; },
-		[](bool boolean) { return (number) boolean; },
-		[](number num) { return num; },
-		[](shared_ptr<string> const& str) {
-			// a custom `stroll` that will will just stop at the first invalid character
-			number ret = 0;
-			auto begin = std::find_if_not(str->cbegin(), str->cend(), [](char c) { return std::isspace(c); });
+Ref<String> Value::to_string() const {
+	if (is_number()) {
+		char buffer[MAX_NUMBER_LENGTH];
+		return String::create(format_number(as_number(), buffer));
+	}
 
-			if (begin == str->cend())
-				return (number) 0;
+	switch (data) {
+	case NULL_: return Ref<String>::share(String::NULL_STRING);
+	case TRUE_: return Ref<String>::share(String::TRUE_STRING);
+	case FALSE_: return Ref<String>::share(String::FALSE_STRING);
+	}
 
-			int sign = (*begin == '-') ? -1 : 1;
+	switch (tag()) {
+	case TAG_STRING:
+		return Ref<String>::share(*as_string());
+	case TAG_VARIABLE: {
+		Value scratch;
+		return Variable::borrow(as_variable(), scratch).to_string();
+	}
+	default:
+		return as_function()->run().to_string();
+	}
+}
 
-			if (*begin == '-' || *begin == '+')
-				++begin;
+size_t Value::string_length() const {
+	if (is_number())
+		return number_length(as_number());
 
-			for (; begin != str->cend() && std::isdigit(*begin); ++begin)
-				ret = ret * 10 + (*begin - '0');
+	if (is_string())
+		return as_string()->length();
+
+	if (is_variable()) {
+		Value scratch;
+		return Variable::borrow(as_variable(), scratch).string_length();
+	}
 
-			return ret * sign;
-		},
-		[](shared_ptr<Variable> const& var) { return var->run().to_number(); },
-		[](shared_ptr<Function> const& func) { return func->run().to_number(); },
-	}, data);
+	if (is_function())
+		return as_function()->run().string_length();
+
+	// null and the booleans convert to static strings, so this doesn't allocate.
+	return to_string()->length();
 }
 
+std::string_view Value::to_string_view(char (&buffer)[MAX_NUMBER_LENGTH], Value& scratch) const {
+	if (is_number())
+		return format_number(as_number(), buffer);
+
+	if (is_string())
+		return as_string()->view();
+
+	auto const& value = is_variable() || is_function() ? (scratch = run()) : *this;
 
-shared_ptr<string> Value::to_string() {
-	return std::visit(overload {
-		[](null) {
-			static shared_ptr<string> null_string = make_shared<string>("null");
-			return null_string;
-		},
-		[](bool boolean) {
-			static shared_ptr<string> true_string = make_shared<string>("true");
-			static shared_ptr<string> false_string = make_shared<string>("false");
-			return boolean ? true_string : false_string;
-		},
-		[](number num) { return make_shared<string>(std::to_string(num)); },
-		[](shared_ptr<string> const& str) { return str; },
-		[](shared_ptr<Variable> const& var) { return var->run().to_string(); },
-		[](shared_ptr<Function> const& func) { return func->run().to_string(); },
-	}, data);
+	if (value.is_number())
+		return format_number(value.as_number(), buffer);
+
+	scratch = Value(value.to_string());
+	return scratch.as_string()->view();
 }
 
-shared_ptr<Variable> Value::as_variable() const {
-	if (auto var = std::get_if<shared_ptr<Variable>>(&data))
-		return *var;
+// Compares `lhs` with `rhs` converted to a string, without creating the string for numbers.
+static int compare_string(std::string_view lhs, Value const& rhs) {
+	if (rhs.is_number()) {
+		char buffer[MAX_NUMBER_LENGTH];
+		return lhs.compare(format_number(rhs.as_number(), buffer));
+	}
 
-	throw Error("invalid kind for 'as_variable'");
+	if (rhs.is_string())
+		return lhs.compare(rhs.as_string()->view());
+
+	return lhs.compare(rhs.to_string()->view());
 }
 
 std::ostream& Value::dump(std::ostream& out) const {
-	std::visit(overload {
-		[&](null) { out << "Null()"; }, 
-		[&](bool boolean) { out << (boolean ? "Boolean(true)" : "Boolean(false)"); },
-		[&](number num) { out << "Number(" << num << ")"; },
-		[&](shared_ptr<string> const& str) { out << "String(" << *str << ")"; },
-		[&](shared_ptr<Variable> const& var) { out << var; },
-		[&](shared_ptr<Function> const& func) { out << func; },
-	}, data);
-
-	return out;
+	if (is_number())
+		return out << "Number(" << as_number() << ")";
+
+	switch (data) {
+	case NULL_: return out << "Null()";
+	case TRUE_: return out << "Boolean(true)";
+	case FALSE_: return out << "Boolean(false)";
+	}
+
+	switch (tag()) {
+	case TAG_STRING: return out << "String(" << *as_string() << ")";
+	case TAG_VARIABLE: return Variable::dump(out, as_variable());
+	default: return out << as_function();
+	}
 }
 
-Value Value::run() {
-	if (auto var = std::get_if<shared_ptr<Variable>>(&data))
-		return (*var)->run();
+Value Value::run() const {
+	if (is_variable())
+		return Variable::run(as_variable());
 
-	if (auto func = std::get_if<shared_ptr<Function>>(&data))
-		return (*func)->run();
+	if (is_function())
+		return as_function()->run();
 
 	return *this;
 }
 
-Value Value::operator+(Value&& rhs) {
-	if (auto str = std::get_if<shared_ptr<string>>(&data))
-		return Value(make_shared<string>(**str + *rhs.to_string()));
+Value Value::operator+(Value const& rhs) const {
+	if (is_string()) {
+		// a string `rhs` is shared, so that long ones can become part of a rope rather than being copied.
+		if (rhs.is_string())
+			return Value(String::concat(Ref<String>::share(*as_string()), Ref<String>::share(*rhs.as_string())));
+
+		char buffer[MAX_NUMBER_LENGTH];
+		Value scratch;
+		return Value(String::concat(Ref<String>::share(*as_string()), rhs.to_string_view(buffer, scratch)));
+	}
 
-	if (auto num = std::get_if<number>(&data))
-		return Value(*num + rhs.to_number());
+	if (is_number())
+		return Value(as_number() + rhs.to_number());
 
 	throw Error("invalid kind given to '+'");
 }
 
-Value Value::operator-(Value&& rhs) {
-	if (auto num = std::get_if<number>(&data))
-		return Value(*num - rhs.to_number());
+Value Value::operator-(Value const& rhs) const {
+	if (is_number())
+		return Value(as_number() - rhs.to_number());
 
 	throw Error("invalid kind given to '-'");
 }
 
-Value Value::operator*(Value&& rhs) {
-	if (auto num = std::get_if<number>(&data))
-		return Value(*num * rhs.to_number());
+Value Value::operator*(Value const& rhs) const {
+	if (is_number())
+		return Value(as_number() * rhs.to_number());
 
-	auto str = std::get_if<shared_ptr<string>>(&data);
-
-	if (!str)
+	if (!is_string())
 		throw Error("invalid kind given to '*'");
 
+	auto str = as_string()->view();
 	number rhs_num = rhs.to_number();
 
 	if (rhs_num < 0)
 		throw Error("cannot duplicate by a negative number");
 
-	string ret;
+	auto ret = String::alloc(str.length() * rhs_num);
 
 	for (auto i = 0; i < rhs_num; ++i)
-		ret += **str;
+		std::copy(str.cbegin(), str.cend(), ret->mut_data() + i * str.length());
 
-	return Value(ret);
+	return Value(std::move(ret));
 }
 
-Value Value::operator/(Value&& rhs) {
-	number num;
-
-	if (auto pnum = std::get_if<number>(&data))
-		num = *pnum;
-	else
+Value Value::operator/(Value const& rhs) const {
+	if (!is_number())
 		throw Error("invalid kind given to '/'");
 
 	auto rnum = rhs.to_number();
 
 	if (!rnum)
-		throw new Error("Cannot divide by zero");
+		throw Error("Cannot divide by zero");
 
-	return Value(num / rnum);
+	return Value(as_number() / rnum);
 }
 
-Value Value::operator%(Value&& rhs) {
-	number num;
-
-	if (auto pnum = std::get_if<number>(&data))
-		num = *pnum;
-	else
+Value Value::operator%(Value const& rhs) const {
+	if (!is_number())
 		throw Error("invalid kind given to '%'");
 
 	auto rnum = rhs.to_number();
 
 	if (!rnum)
-		throw new Error("Cannot modulo by zero");
+		throw Error("Cannot modulo by zero");
 
-	return Value(num % rnum);
+	return Value(as_number() % rnum);
 }
 
-Value Value::pow(Value&& rhs) {
-	number base;
-
-	if (auto pbase = std::get_if<number>(&data))
-		base = *pbase;
-	else
+Value Value::pow(Value const& rhs) const {
+	if (!is_number())
 		throw Error("invalid kind given to '%'");
 
+	number base = as_number();
 	number exp = rhs.to_number();
 	number ret;
 
@@ -278,38 +407,29 @@ Value Value::pow(Value&& rhs) {
 	return Value(ret);
 }
 
-bool Value::operator==(Value&& rhs) {
-	if (data.index() != rhs.data.index())
+bool Value::operator==(Value const& rhs) const {
+	if (data == rhs.data)
+		return true;
+
+	// only strings can be equal without having the same representation.
+	if (!is_string() || !rhs.is_string())
 		return false;
 
-	return std::visit(overload {
-		[&](null) { return true; },
-		[&](bool boolean) { return boolean == std::get<bool>(rhs.data); },
-		[&](number num) { return num == std::get<number>(rhs.data); },
-		[&](shared_ptr<string> const& str) { return *str == *std::get<shared_ptr<string>>(rhs.data); },
-		[&](shared_ptr<Variable> const& var) { return var == std::get<shared_ptr<Variable>>(rhs.data); },
-		[&](shared_ptr<Function> const& var) { return var == std::get<shared_ptr<Function>>(rhs.data); }
-	}, data);
+	return as_string()->view() == rhs.as_string()->view();
 }
 
-bool Value::operator<(Value&& rhs) {
-	return std::visit([&](auto&& lhs) -> bool {
-		using T = std::decay_t<decltype(lhs)>;
+bool Value::operator<(Value const& rhs) const {
+	if (is_number()) return as_number() < rhs.to_number();
+	if (is_string()) return compare_string(as_string()->view(), rhs) < 0;
+	if (is_boolean()) return rhs.to_boolean() && data == FALSE_;
 
-		if constexpr (std::is_same_v<T, number>) return lhs < rhs.to_number();
-		else if constexpr (std::is_same_v<T, shared_ptr<string>>) return *lhs < *rhs.to_string();
-		else if constexpr (std::is_same_v<T, bool>) return rhs.to_boolean() && !lhs;
-		else throw Error("invalid kind given to '<'");
-	}, data);
+	throw Error("invalid kind given to '<'");
 }
 
-bool Value::operator>(Value&& rhs) {
-	return std::visit([&](auto&& lhs) -> bool {
-		using T = std::decay_t<decltype(lhs)>;
+bool Value::operator>(Value const& rhs) const {
+	if (is_number()) return as_number() > rhs.to_number();
+	if (is_string()) return compare_string(as_string()->view(), rhs) > 0;
+	if (is_boolean()) return !rhs.to_boolean() && data == TRUE_;
 
-		if constexpr (std::is_same_v<T, number>) return lhs > rhs.to_number();
-		else if constexpr (std::is_same_v<T, shared_ptr<string>>) return *lhs > *rhs.to_string();
-		else if constexpr (std::is_same_v<T, bool>) return !rhs.to_boolean() && lhs;
-		else throw Error("invalid kind given to '>'");
-	}, data);
+	throw Error("invalid kind given to '>'");
 }
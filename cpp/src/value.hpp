@@ -1,60 +1,172 @@
 #pragma once
 
 #include "error.hpp"
+#include "string.hpp"
 #include <string>
 #include <string_view>
 #include <memory>
-#include <variant>
 #include <ostream>
 #include <optional>
+#include <algorithm>
+#include <cstdint>
 
 namespace kn {
 	using number = long long;
-	using string = std::string;
+
+	// The index of a variable within an interpreter's `Environment`.
+	using slot_t = uint32_t;
 	struct null {};
 
+	// The most bytes a number can take up when converted to a string: a sign, followed by up to 19 digits.
+	constexpr size_t MAX_NUMBER_LENGTH = 20;
+
+	// Converts `num` to a string within `buffer`, returning a view of it. This never allocates.
+	std::string_view format_number(number num, char (&buffer)[MAX_NUMBER_LENGTH]) noexcept;
+
+	// Returns how many bytes `num` takes up when converted to a string, without converting it.
+	size_t number_length(number num) noexcept;
 
 	class Variable;
 	class Function;
+	class Arena;
+
+	// The type that represents all values within Knight.
+	//
+	// A `Value` is a single tagged 64-bit word; see `value.cpp` for the precise layout.
+	class Value {
+		uint64_t data;
+
+		enum : uint64_t {
+			FALSE_ = 0,
+			NULL_ = 2,
+			TRUE_ = 4,
+			UNDEFINED_ = 6,
+
+			TAG_STRING = 0,
+			TAG_NUMBER = 1,
+			TAG_VARIABLE = 2,
+			TAG_FUNCTION = 4,
+			TAG_MASK = 7
+		};
+
+		uint64_t tag() const noexcept { return data & TAG_MASK; }
 
-class Value {
-	std::variant<
-		null,
-		bool,
-		number,
-		std::shared_ptr<string>,
-		std::shared_ptr<Variable>,
-		std::shared_ptr<Function>
-	> data;
+		// Functions are reference counted through the arena that owns them.
+		void incref_function() const noexcept;
+		void decref_function() const noexcept;
+
+		// Forgets about the function this value refers to, without releasing the reference.
+		void forget() noexcept { data = NULL_; }
+		friend class Function;
+
+		// Parses a single literal, variable, or function name from the start of `view`, without its arguments.
+		static std::optional<Value> parse_token(std::string_view& view, Arena& arena);
 
 	public:
 
-		explicit Value() noexcept;
-		explicit Value(bool boolean) noexcept;
-		explicit Value(number num) noexcept;
-		explicit Value(string str) noexcept;
-		explicit Value(std::shared_ptr<string> str) noexcept;
-		explicit Value(std::shared_ptr<Variable> var) noexcept;
-		explicit Value(std::shared_ptr<Function> func) noexcept;
+		// Checks for the kind of value this is.
+		bool is_null() const noexcept { return data == NULL_; }
+		bool is_number() const noexcept { return data & TAG_NUMBER; }
+		bool is_boolean() const noexcept { return data == FALSE_ || data == TRUE_; }
+		bool is_string() const noexcept { return data != FALSE_ && tag() == TAG_STRING; }
+		bool is_variable() const noexcept { return data != TAG_VARIABLE && tag() == TAG_VARIABLE; }
+		bool is_function() const noexcept { return data != TRUE_ && tag() == TAG_FUNCTION; }
+
+		// Whether this is the value of a variable that's never been assigned.
+		bool is_undefined() const noexcept { return data == UNDEFINED_; }
+
+		// Accesses the contents of this value; it's up to the caller to check that it's the right kind.
+		number as_number() const noexcept { return static_cast<number>(static_cast<int64_t>(data) >> 1); }
+		String* as_string() const noexcept { return reinterpret_cast<String*>(data & ~TAG_MASK); }
+		slot_t as_variable() const noexcept { return static_cast<slot_t>(data >> 3); }
+		Function* as_function() const noexcept { return reinterpret_cast<Function*>(data & ~TAG_MASK); }
+
+		explicit Value() noexcept : data(NULL_) {}
+		explicit Value(bool boolean) noexcept : data(boolean ? TRUE_ : FALSE_) {}
+		explicit Value(number num) noexcept : data((static_cast<uint64_t>(num) << 1) | TAG_NUMBER) {}
+		explicit Value(Ref<String> str) noexcept;
+		explicit Value(Function* func) noexcept;
+
+		// Creates a value that refers to the variable at `slot`, which must not be zero.
+		static Value variable(slot_t slot) noexcept {
+			Value ret;
+			ret.data = (static_cast<uint64_t>(slot) << 3) | TAG_VARIABLE;
+			return ret;
+		}
+
+		// Creates the value of a variable that's never been assigned; it's never seen outside of `Variable`.
+		static Value undefined() noexcept {
+			Value ret;
+			ret.data = UNDEFINED_;
+			return ret;
+		}
+
+		// Parses a value from the start of `view`, allocating any functions within a new arena.
 		static std::optional<Value> parse(std::string_view& view);
 
-		Value run();
+		// Parses a value from the start of `view`, allocating any functions within `arena`.
+		//
+		// This uses an explicit stack rather than recursion, so how deeply programs can nest is only limited by memory.
+		static std::optional<Value> parse(std::string_view& view, Arena& arena);
+
+		Value(Value const& rhs) noexcept : data(rhs.data) {
+			if (is_string())
+				as_string()->incref();
+			else if (is_function())
+				incref_function();
+		}
+
+		Value(Value&& rhs) noexcept : data(rhs.data) {
+			rhs.data = NULL_;
+		}
+
+		Value& operator=(Value const& rhs) noexcept {
+			Value tmp(rhs);
+			std::swap(data, tmp.data);
+			return *this;
+		}
+
+		Value& operator=(Value&& rhs) noexcept {
+			std::swap(data, rhs.data);
+			return *this;
+		}
+
+		~Value() {
+			if (is_string())
+				as_string()->decref();
+			else if (is_function())
+				decref_function();
+		}
+
+		Value run() const;
 		std::ostream& dump(std::ostream& out) const;
 
-		bool to_boolean();
-		number to_number();
-		std::shared_ptr<string> to_string();
-		std::shared_ptr<Variable> as_variable() const;
-
-		Value operator+(Value&& rhs);
-		Value operator-(Value&& rhs);
-		Value operator*(Value&& rhs);
-		Value operator/(Value&& rhs);
-		Value operator%(Value&& rhs);
-		Value pow(Value&& rhs);
-
-		bool operator==(Value&& rhs);
-		bool operator<(Value&& rhs);
-		bool operator>(Value&& rhs);
+		// Converts this to the given kind, running it first if it's a variable or function.
+		//
+		// Variables are converted in place rather than being copied out of the environment first.
+		bool to_boolean() const;
+		number to_number() const;
+		Ref<String> to_string() const;
+
+		// Returns the length of this when converted to a string, without creating the string for numbers.
+		size_t string_length() const;
+
+		// Returns the bytes of this when converted to a string, for callers that don't need a `String` of their own.
+		//
+		// Numbers are formatted into `buffer` rather than a new string, and the results of running variables and
+		// functions are stored in `scratch`; the view is only valid for as long as both of them are.
+		std::string_view to_string_view(char (&buffer)[MAX_NUMBER_LENGTH], Value& scratch) const;
+
+		// The operators only inspect `rhs`, so they can be given borrowed values (see `borrow_arg`).
+		Value operator+(Value const& rhs) const;
+		Value operator-(Value const& rhs) const;
+		Value operator*(Value const& rhs) const;
+		Value operator/(Value const& rhs) const;
+		Value operator%(Value const& rhs) const;
+		Value pow(Value const& rhs) const;
+
+		bool operator==(Value const& rhs) const;
+		bool operator<(Value const& rhs) const;
+		bool operator>(Value const& rhs) const;
 	};
 }
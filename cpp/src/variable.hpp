@@ -1,39 +1,56 @@
 #pragma once
 
-#include "knight.hpp"
 #include "value.hpp"
+#include "interpreter.hpp"
 #include <optional>
+#include <string_view>
 
 namespace kn {
-	// A variable within Knight.
+	// The variables within Knight.
 	//
-	// As per the Knight specs, all variables are global.
+	// Variables are stored in the `Environment` of the current `Interpreter`; this just forwards to it.
 	class Variable {
-		// The name of the variable.
-		std::string const name;
-
-		// The value associated with this variable.
-		std::optional<Value> value;
 	public:
-
-		// Creates a new Variable with the given name.
-		explicit Variable(std::string name) noexcept;
-
-		// There is no default variable.
+		// Variables are only ever referred to by their slot.
 		Variable() = delete;
 
-		// Parses an Variable out, or returns `nullptr` if the first character isn't a letter or `_`.
+		// Parses an identifier out, returning a `Value` referring to its slot, or `nullopt` if the first character
+		// isn't a lowercase letter or `_`.
 		static std::optional<Value> parse(std::string_view& view);
 
-		// Runs the variable, looking up its last assigned value.
+		// Returns the slot of the variable called `name`, giving it a new one if it's never been seen before.
+		static slot_t lookup(std::string_view name) {
+			return Interpreter::current().environment.lookup(name);
+		}
+
+		// Returns the name of the variable at `slot`.
+		static std::string_view name(slot_t slot) noexcept {
+			return Interpreter::current().environment.name(slot);
+		}
+
+		// Looks up the value last assigned to the variable at `slot`.
 		//
 		// Throws an `Error` if the variable was never assigned.
-		Value run();
+		static Value run(slot_t slot) {
+			return Interpreter::current().environment.run(slot);
+		}
+
+		// Looks up the variable at `slot` like `run`, but without copying its value.
+		//
+		// The reference is only valid until something else is run, as that could reassign the variable. For the same
+		// reason blocks are still copied (into `scratch`), as running one could otherwise free it partway through.
+		static Value const& borrow(slot_t slot, Value& scratch) {
+			auto& value = Interpreter::current().environment.borrow(slot);
+
+			return value.is_function() ? (scratch = value) : value;
+		}
 
-		// Provides debugging output of this type.
-		std::ostream& dump(std::ostream& out) const noexcept;
+		// Assigns a value to the variable at `slot`, discarding its previous value.
+		static void assign(slot_t slot, Value value) noexcept {
+			Interpreter::current().environment.assign(slot, std::move(value));
+		}
 
-		// Assigns a value to this variable, discarding its previous value.
-		void assign(Value newvalue) noexcept;
+		// Provides debugging output of the variable at `slot`.
+		static std::ostream& dump(std::ostream& out, slot_t slot);
 	};
 }
@@ -0,0 +1,458 @@
+#include "vm.hpp"
+#include "function.hpp"
+#include "variable.hpp"
+#include "interpreter.hpp"
+
+using namespace kn;
+
+// Whether to use computed gotos for dispatching instructions, rather than a `switch`.
+#if defined(__GNUC__) && !defined(KN_VM_SWITCH_DISPATCH)
+# define KN_VM_COMPUTED_GOTO
+// computed gotos are a GNU extension, which `-Wpedantic` would otherwise warn about on every label.
+# pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+// The largest arity that `BUILTIN` supports; functions with more arguments are run with `RUN_NODE`.
+static constexpr uint32_t MAX_BUILTIN_ARITY = 4;
+
+// The stack that all bytecode executing on a thread shares; each call to `execute` only uses the values above where
+// it started.
+static thread_local std::vector<Value> STACK;
+
+namespace {
+	// Where to return to once a block that's been called returns.
+	struct Frame {
+		Bytecode* bytecode;
+		uint32_t ip;
+
+		// The block that was called, which keeps its arena (and thus bytecode) alive while it's running.
+		Value block;
+	};
+}
+
+// The frames of all blocks that are being called, shared like `STACK`.
+static thread_local std::vector<Frame> FRAMES;
+
+uint32_t Bytecode::add_constant(Value const& value) {
+	constants.push_back(value);
+	return static_cast<uint32_t>(constants.size() - 1);
+}
+
+uint32_t Bytecode::add_function(Function* function) {
+	functions.push_back(function);
+	return static_cast<uint32_t>(functions.size() - 1);
+}
+
+uint32_t Bytecode::emit_jump(Opcode opcode) {
+	emit(opcode, 0);
+	return static_cast<uint32_t>(code.size() - 1);
+}
+
+uint32_t Bytecode::entry(Function& func) {
+	if (auto match = entries.find(&func); match != entries.cend())
+		return match->second;
+
+	auto start = static_cast<uint32_t>(code.size());
+	compile_function(func);
+	emit(Opcode::RETURN);
+	entries.emplace(&func, start);
+
+	return start;
+}
+
+void Bytecode::compile_leaf(Value const& value) {
+	if (value.is_variable())
+		emit(Opcode::LOAD_VARIABLE, value.as_variable());
+	else if (value.is_null())
+		emit(Opcode::PUSH_NULL);
+	else
+		emit(Opcode::PUSH_CONSTANT, add_constant(value));
+}
+
+void Bytecode::compile_function(Function& root) {
+	// rather than recursing into arguments, each function being compiled has a frame that tracks how far along it is
+	// (`phase`), along with any jumps that need to be patched once later code is emitted.
+	struct Frame {
+		Function* func;
+		uint32_t phase;
+		uint32_t first;
+		uint32_t second;
+	};
+
+	std::vector<Frame> frames { Frame { &root, 0, 0, 0 } };
+
+	// Compiles `value`: leaves are emitted immediately, whereas functions get a frame of their own. This invalidates
+	// references to the current frame, so it must be the last thing a phase does with it.
+	auto descend = [&](Value const& value) {
+		if (value.is_function())
+			frames.push_back(Frame { value.as_function(), 0, 0, 0 });
+		else
+			compile_leaf(value);
+	};
+
+	while (!frames.empty()) {
+		auto& frame = frames.back();
+		auto func = frame.func;
+		auto args = func->args();
+		auto phase = frame.phase++;
+		Opcode opcode;
+
+		switch (func->name()) {
+		case 'B':
+			if (args[0].is_function())
+				emit(Opcode::PUSH_FUNCTION, add_function(args[0].as_function()));
+			else
+				emit(Opcode::PUSH_CONSTANT, add_constant(args[0]));
+			goto done;
+
+		case 'C':
+			if (phase == 0)
+				descend(args[0]);
+			else {
+				emit(Opcode::CALL);
+				goto done;
+			}
+			continue;
+
+		case 'E':
+			if (phase == 0)
+				descend(args[0]);
+			else {
+				emit(Opcode::EVAL);
+				goto done;
+			}
+			continue;
+
+		case ';':
+			if (phase == 0)
+				descend(args[0]);
+			else if (phase == 1) {
+				emit(Opcode::POP);
+				descend(args[1]);
+			} else
+				goto done;
+			continue;
+
+		case '=':
+			// assigning to a non-variable is an error, which `RUN_NODE` will raise.
+			if (!args[0].is_variable())
+				break;
+
+			if (phase == 0)
+				descend(args[1]);
+			else {
+				emit(Opcode::STORE_VARIABLE, args[0].as_variable());
+				goto done;
+			}
+			continue;
+
+		case 'W':
+			if (phase == 0) {
+				frame.first = static_cast<uint32_t>(code.size());
+				descend(args[0]);
+			} else if (phase == 1) {
+				frame.second = emit_jump(Opcode::JUMP_IF_FALSE);
+				descend(args[1]);
+			} else {
+				emit(Opcode::POP);
+				emit(Opcode::JUMP, frame.first);
+				patch(frame.second);
+				emit(Opcode::PUSH_NULL);
+				goto done;
+			}
+			continue;
+
+		case 'I':
+			if (phase == 0)
+				descend(args[0]);
+			else if (phase == 1) {
+				frame.first = emit_jump(Opcode::JUMP_IF_FALSE);
+				descend(args[1]);
+			} else if (phase == 2) {
+				frame.second = emit_jump(Opcode::JUMP);
+				patch(frame.first);
+				descend(args[2]);
+			} else {
+				patch(frame.second);
+				goto done;
+			}
+			continue;
+
+		case '&':
+		case '|':
+			if (phase == 0)
+				descend(args[0]);
+			else if (phase == 1) {
+				frame.first = emit_jump(func->name() == '&' ? Opcode::JUMP_IF_FALSE_OR_POP : Opcode::JUMP_IF_TRUE_OR_POP);
+				descend(args[1]);
+			} else {
+				patch(frame.first);
+				goto done;
+			}
+			continue;
+
+		case '!':
+			if (phase == 0)
+				descend(args[0]);
+			else {
+				emit(Opcode::NOT);
+				goto done;
+			}
+			continue;
+
+		case '+': opcode = Opcode::ADD; goto binary;
+		case '-': opcode = Opcode::SUB; goto binary;
+		case '*': opcode = Opcode::MUL; goto binary;
+		case '/': opcode = Opcode::DIV; goto binary;
+		case '%': opcode = Opcode::MOD; goto binary;
+		case '^': opcode = Opcode::POW; goto binary;
+		case '?': opcode = Opcode::EQL; goto binary;
+		case '<': opcode = Opcode::LTH; goto binary;
+		case '>': opcode = Opcode::GTH; goto binary;
+		binary:
+			if (phase < 2)
+				descend(args[phase]);
+			else {
+				emit(opcode);
+				goto done;
+			}
+			continue;
+
+		// these builtins only use their arguments by converting them, which doesn't run the values that arguments evaluate
+		// to, except for blocks (which can't be converted anyway). `DUMP` can be given a block, so it's run as a node.
+		case 'P': case 'R': case '`': case 'Q': case 'L': case 'O': case 'G': case 'S':
+			if (MAX_BUILTIN_ARITY < func->arity())
+				break;
+
+			if (phase < func->arity())
+				descend(args[phase]);
+			else {
+				emit(Opcode::BUILTIN, add_function(func));
+				goto done;
+			}
+			continue;
+		}
+
+		emit(Opcode::RUN_NODE, add_function(func));
+
+	done:
+		frames.pop_back();
+	}
+}
+
+namespace {
+	// Truncates the stacks back to where they were when an `execute` started, even if it exits via an exception.
+	struct StackGuard {
+		size_t base;
+		size_t frames;
+
+		~StackGuard() {
+			if (base < STACK.size())
+				STACK.erase(STACK.begin() + base, STACK.end());
+
+			if (frames < FRAMES.size())
+				FRAMES.erase(FRAMES.begin() + frames, FRAMES.end());
+		}
+	};
+}
+
+Value Vm::run(Value const& value) {
+	if (value.is_function())
+		return run(*value.as_function());
+
+	return Value(value).run();
+}
+
+Value Vm::run(Function& func) {
+	auto& bytecode = func.arena().bytecode();
+
+	return execute(bytecode, bytecode.entry(func));
+}
+
+// Removes and returns the top of `stack`.
+static Value pop(std::vector<Value>& stack) {
+	auto value = std::move(stack.back());
+	stack.pop_back();
+	return value;
+}
+
+Value Vm::execute(Bytecode& start, uint32_t ip) {
+	// the stacks are thread-local, which is only worth looking up once.
+	auto& stack = STACK;
+	auto& frames = FRAMES;
+	StackGuard guard { stack.size(), frames.size() };
+
+	// the bytecode of the block that's currently running.
+	Bytecode* bytecode = &start;
+
+	// `code` has to be reloaded whenever something could've compiled more functions into `bytecode`.
+	//
+	// Note that instructions with locals must dispatch outside of their block: a computed `goto` out of a scope doesn't
+	// run the destructors of the values within it.
+	uint32_t const* code = bytecode->code.data();
+
+	// Calls `block`, which must be a function: its bytecode is run next, and then returns to the current `ip`.
+	auto call = [&](Value block) {
+		auto func = block.as_function();
+		auto& callee = func->arena().bytecode();
+		auto entry = callee.entry(*func);
+
+		frames.push_back(Frame { bytecode, ip, std::move(block) });
+		bytecode = &callee;
+		ip = entry;
+		code = callee.code.data();
+	};
+
+#ifdef KN_VM_COMPUTED_GOTO
+	static void* const LABELS[] = {
+	# define KN_OPCODE_LABEL(name, operands) &&op_##name,
+		KN_OPCODES(KN_OPCODE_LABEL)
+	# undef KN_OPCODE_LABEL
+	};
+
+# define CASE(name) op_##name:
+# define DISPATCH() goto *LABELS[code[ip++]]
+#else
+# define CASE(name) case Opcode::name:
+# define DISPATCH() continue
+#endif
+
+	for (;;) {
+#ifdef KN_VM_COMPUTED_GOTO
+		DISPATCH();
+#else
+		switch (static_cast<Opcode>(code[ip++])) {
+#endif
+
+		CASE(PUSH_CONSTANT)
+			stack.push_back(bytecode->constants[code[ip++]]);
+			DISPATCH();
+
+		CASE(PUSH_FUNCTION)
+			stack.emplace_back(bytecode->functions[code[ip++]]);
+			DISPATCH();
+
+		CASE(PUSH_NULL)
+			stack.emplace_back();
+			DISPATCH();
+
+		CASE(LOAD_VARIABLE)
+			stack.push_back(Variable::run(code[ip++]));
+			DISPATCH();
+
+		CASE(STORE_VARIABLE)
+			Variable::assign(code[ip++], stack.back());
+			DISPATCH();
+
+		CASE(POP)
+			stack.pop_back();
+			DISPATCH();
+
+		CASE(JUMP)
+			ip = code[ip];
+			DISPATCH();
+
+		CASE(JUMP_IF_FALSE)
+			ip = pop(stack).to_boolean() ? ip + 1 : code[ip];
+			DISPATCH();
+
+		CASE(JUMP_IF_FALSE_OR_POP)
+			if (stack.back().to_boolean()) {
+				stack.pop_back();
+				++ip;
+			} else {
+				ip = code[ip];
+			}
+			DISPATCH();
+
+		CASE(JUMP_IF_TRUE_OR_POP)
+			if (stack.back().to_boolean()) {
+				ip = code[ip];
+			} else {
+				stack.pop_back();
+				++ip;
+			}
+			DISPATCH();
+
+#define KN_VM_BINARY(name, expr) \
+		CASE(name) { \
+			auto rhs = pop(stack); \
+			auto lhs = pop(stack); \
+			stack.push_back(expr); \
+		} \
+		DISPATCH();
+
+		KN_VM_BINARY(ADD, lhs + std::move(rhs))
+		KN_VM_BINARY(SUB, lhs - std::move(rhs))
+		KN_VM_BINARY(MUL, lhs * std::move(rhs))
+		KN_VM_BINARY(DIV, lhs / std::move(rhs))
+		KN_VM_BINARY(MOD, lhs % std::move(rhs))
+		KN_VM_BINARY(POW, lhs.pow(std::move(rhs)))
+		KN_VM_BINARY(EQL, Value(lhs == std::move(rhs)))
+		KN_VM_BINARY(LTH, Value(lhs < std::move(rhs)))
+		KN_VM_BINARY(GTH, Value(lhs > std::move(rhs)))
+#undef KN_VM_BINARY
+
+		CASE(NOT)
+			stack.back() = Value(!stack.back().to_boolean());
+			DISPATCH();
+
+		CASE(CALL) {
+			auto block = pop(stack);
+
+			if (block.is_function())
+				call(std::move(block));
+			else
+				stack.push_back(block.run());
+		}
+		DISPATCH();
+
+		CASE(EVAL) {
+			char buffer[MAX_NUMBER_LENGTH];
+			Value scratch;
+			auto program = Interpreter::current().eval_cache.lookup(pop(stack).to_string_view(buffer, scratch));
+
+			if (program.is_function())
+				call(std::move(program));
+			else
+				stack.push_back(program.run());
+		}
+		DISPATCH();
+
+		CASE(BUILTIN) {
+			auto func = bytecode->functions[code[ip++]];
+			auto arity = func->arity();
+
+			// move the arguments off the stack, as the builtin may reenter the virtual machine and grow it.
+			Value args[MAX_BUILTIN_ARITY];
+			std::move(stack.end() - arity, stack.end(), args);
+			stack.erase(stack.end() - arity, stack.end());
+
+			stack.push_back(func->function()(args));
+			code = bytecode->code.data();
+		}
+		DISPATCH();
+
+		CASE(RUN_NODE)
+			stack.push_back(bytecode->functions[code[ip++]]->run());
+			code = bytecode->code.data();
+			DISPATCH();
+
+		CASE(RETURN)
+			if (frames.size() == guard.frames)
+				return pop(stack);
+
+			bytecode = frames.back().bytecode;
+			ip = frames.back().ip;
+			code = bytecode->code.data();
+			frames.pop_back();
+			DISPATCH();
+
+#ifndef KN_VM_COMPUTED_GOTO
+		}
+#endif
+	}
+
+#undef CASE
+#undef DISPATCH
+}
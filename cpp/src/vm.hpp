@@ -0,0 +1,100 @@
+#pragma once
+
+#include "value.hpp"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace kn {
+	// All the instructions the virtual machine knows about, along with how many operands they take.
+	#define KN_OPCODES(X) \
+		X(PUSH_CONSTANT, 1)        /* pushes `constants[operand]` */ \
+		X(PUSH_FUNCTION, 1)        /* pushes `functions[operand]` as a value, as `BLOCK` does */ \
+		X(PUSH_NULL, 0)            /* pushes null */ \
+		X(LOAD_VARIABLE, 1)        /* pushes the value of the variable at slot `operand` */ \
+		X(STORE_VARIABLE, 1)       /* assigns the top of the stack to the variable at slot `operand`, leaving it there */ \
+		X(POP, 0)                  /* discards the top of the stack */ \
+		X(JUMP, 1)                 /* jumps to `operand` */ \
+		X(JUMP_IF_FALSE, 1)        /* pops the top of the stack, jumping to `operand` if it's falsey */ \
+		X(JUMP_IF_FALSE_OR_POP, 1) /* jumps to `operand` if the top is falsey; pops it otherwise */ \
+		X(JUMP_IF_TRUE_OR_POP, 1)  /* jumps to `operand` if the top is truthy; pops it otherwise */ \
+		X(ADD, 0) \
+		X(SUB, 0) \
+		X(MUL, 0) \
+		X(DIV, 0) \
+		X(MOD, 0) \
+		X(POW, 0) \
+		X(EQL, 0) \
+		X(LTH, 0) \
+		X(GTH, 0) \
+		X(NOT, 0) \
+		X(CALL, 0)                 /* pops a value and runs it, running blocks through the virtual machine */ \
+		X(EVAL, 0)                 /* pops a value, and parses and runs it like `CALL` */ \
+		X(BUILTIN, 1)              /* calls `functions[operand]`'s function pointer with its arguments on the stack */ \
+		X(RUN_NODE, 1)             /* runs `functions[operand]` with the tree-walking interpreter */ \
+		X(RETURN, 0)               /* returns the top of the stack to the caller */
+
+	enum class Opcode : uint32_t {
+	#define KN_OPCODE_ENUM(name, operands) name,
+		KN_OPCODES(KN_OPCODE_ENUM)
+	#undef KN_OPCODE_ENUM
+	};
+
+	// Bytecode compiled from the functions of a single `Arena`, which is freed along with it.
+	//
+	// Functions are compiled lazily, the first time they're run by the virtual machine: each one becomes an entry
+	// point into the same linear `code`, which ends in a `RETURN`.
+	class Bytecode {
+		friend class Vm;
+
+		// The instructions and their operands.
+		std::vector<uint32_t> code;
+
+		// The literal values used by `PUSH_CONSTANT`.
+		std::vector<Value> constants;
+
+		// The functions used by `PUSH_FUNCTION`, `BUILTIN`, and `RUN_NODE`. These aren't `Value`s, as that would make
+		// the arena own a reference to itself.
+		std::vector<Function*> functions;
+
+		// The offset within `code` of each compiled function.
+		std::unordered_map<Function const*, uint32_t> entries;
+
+		// Returns the offset of `func` within `code`, compiling it if it hasn't been already.
+		uint32_t entry(Function& func);
+
+		uint32_t add_constant(Value const& value);
+		uint32_t add_function(Function* function);
+
+		void emit(Opcode opcode) { code.push_back(static_cast<uint32_t>(opcode)); }
+		void emit(Opcode opcode, uint32_t operand) { emit(opcode); code.push_back(operand); }
+
+		// Emits a jump whose target is filled in later by `patch`; returns the location of the target.
+		uint32_t emit_jump(Opcode opcode);
+
+		// Sets the jump target at `location` to the next instruction.
+		void patch(uint32_t location) { code[location] = static_cast<uint32_t>(code.size()); }
+
+		// Emits the instructions for a literal or variable.
+		void compile_leaf(Value const& value);
+
+		// Emits the instructions for `func`, using an explicit stack rather than recursing into its arguments.
+		void compile_function(Function& func);
+	};
+
+	// The bytecode virtual machine, an alternative to the tree-walking interpreter (ie `Value::run`).
+	//
+	// Calling a block (whether via `CALL` or `EVAL`) doesn't recurse: the caller's position is saved in a frame on
+	// the heap, so how deeply blocks can call each other is only limited by memory.
+	class Vm {
+		// Executes `bytecode` starting at `ip`, until its outermost `RETURN` is reached.
+		static Value execute(Bytecode& bytecode, uint32_t ip);
+
+	public:
+		// Runs `value`, compiling it to bytecode first if it's a function.
+		static Value run(Value const& value);
+
+		// Runs `func` via its arena's bytecode.
+		static Value run(Function& func);
+	};
+}
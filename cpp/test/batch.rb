@@ -0,0 +1,51 @@
+require_relative 'helper'
+require 'tmpdir'
+require 'fileutils'
+
+describe 'batch mode' do
+	include Kn::Cpp
+
+	before { @dir = Dir.mktmpdir }
+	after { FileUtils.rm_rf @dir }
+
+	# Writes each of `programs` to its own file, returning their paths in order.
+	def files(*programs)
+		programs.each_with_index.map do |program, index|
+			File.join(@dir, "#{index}.kn").tap { |path| File.write(path, program) }
+		end
+	end
+
+	# Programs that take differing amounts of time, so they'd finish out of order if their outputs weren't reordered.
+	def programs
+		(0...8).map { |i| "; = i 0 ; W < i #{(8 - i) * 2000} = i + i 1 O #{i}" }
+	end
+
+	it 'writes the outputs in the order of the files' do
+		paths = files(*programs)
+		expected = (0...8).map { |i| "#{i}\n" }.join
+
+		['--jobs=1', '--jobs=3', '--jobs=8', '--jobs=0'].each do |jobs|
+			out, _, status = knight(jobs, '-b', *paths)
+
+			assert_equal expected, out, jobs
+			assert_equal 0, status.exitstatus, jobs
+		end
+	end
+
+	it 'exits with the largest status' do
+		paths = files('; O "a" Q 3', 'Q 9', '; O "c" / 1 0', 'O "d"')
+
+		['--jobs=1', '--jobs=4'].each do |jobs|
+			out, err, status = knight(jobs, '-b', *paths)
+
+			assert_equal "a\nc\nd\n", out, jobs
+			assert_equal 9, status.exitstatus, jobs
+			assert_match(/error with #{Regexp.escape paths[2]}: .*divide by zero/, err, jobs)
+		end
+	end
+
+	it 'reports its stats' do
+		_, err, _ = knight('--jobs=2', '--stats', '-b', *files(*programs))
+		assert_match(/batch: 8 programs, \d+ steals/, err)
+	end
+end
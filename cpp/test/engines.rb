@@ -0,0 +1,26 @@
+require_relative 'helper'
+
+describe 'engines' do
+	include Kn::Cpp
+
+	ENGINES = [%w[--engine=vm], %w[--jit], %w[--fold]]
+
+	# Runs `program` with the tree walker and then each of the other engines, checking they have the same output and
+	# status. Functions are dumped as their addresses, which differ between runs, so those are ignored.
+	def assert_same(program)
+		expected = knight('-e', program)
+
+		ENGINES.each do |options|
+			actual = knight(*options, '-e', program)
+
+			assert_equal expected[0].gsub(/0x\h+/, '0x'), actual[0].gsub(/0x\h+/, '0x'), "#{options.join ' '}: #{program}"
+			assert_equal expected[2].exitstatus, actual[2].exitstatus, "#{options.join ' '}: #{program}"
+		end
+	end
+
+	it 'dumps values without running them again' do
+		assert_same 'D B O "x"'
+		assert_same '; = b B O "x" ; D b C b'
+		assert_same 'D + "a" 1'
+	end
+end
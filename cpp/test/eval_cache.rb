@@ -0,0 +1,32 @@
+require_relative 'helper'
+
+describe 'EVAL cache' do
+	include Kn::Cpp
+
+	# Runs `program` with `options`, checking its output and returning the cache's stats.
+	def stats(program, output, *options)
+		out, err, _ = knight(*options, '--stats', '-e', program)
+		assert_equal output, out, program
+		err[/^eval cache: .*$/]
+	end
+
+	it 'hits on repeated sources and misses on distinct ones' do
+		assert_equal 'eval cache: 2 hits, 2 misses, 0 evictions, 2/256 entries',
+			stats('; O E "1" ; O E "+ 1 1" ; O E "1" O E "+ 1 1"', "1\n2\n1\n2\n")
+	end
+
+	it 'evicts the least recently used program' do
+		# "1" is used after "2", so "3" evicts "2", and "1" is still cached afterwards.
+		program = '; E "1" ; E "2" ; E "1" ; E "3" ; O E "1" O E "2"'
+
+		[[], ['--engine=vm']].each do |engine|
+			assert_equal 'eval cache: 2 hits, 4 misses, 2 evictions, 2/2 entries',
+				stats(program, "1\n2\n", '--eval-cache=2', *engine)
+		end
+	end
+
+	it 'caches nothing with a capacity of zero' do
+		assert_equal 'eval cache: 0 hits, 3 misses, 0 evictions, 0/0 entries',
+			stats('; E "1" ; E "1" O E "1"', "1\n", '--eval-cache=0')
+	end
+end
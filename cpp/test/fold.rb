@@ -0,0 +1,32 @@
+require_relative 'helper'
+
+describe 'Constant folding' do
+	include Kn::Cpp
+
+	it 'folds literal subtrees' do
+		out, err, _ = knight('--fold', '--stats', '-e', 'O + * 2 3 ^ 2 10')
+		assert_equal "1030\n", out
+		assert_match(/constant folding: 3 nodes folded/, err)
+	end
+
+	it 'leaves errors to be raised when they are run' do
+		out, _, status = knight('--fold', '-e', '; O "before" / 1 0')
+		assert_equal "before\n", out
+		assert_equal 1, status.exitstatus
+
+		out, _, status = knight('--fold', '-e', 'O I F (/ 1 0) 0')
+		assert_equal "0\n", out
+		assert_equal 0, status.exitstatus
+	end
+
+	it "doesn't evaluate expensive branches that never run" do
+		assert_equal "0\n", knight('--fold', '-e', 'O I F (^ 2 99999999999) 0')[0]
+		assert_equal "0\n", knight('--fold', '-e', 'O I F (* "abc" 9999999999999) 0')[0]
+	end
+
+	it 'leaves the bodies of blocks alone' do
+		out, err, _ = knight('--fold', '--stats', '-e', '; D B + 1 2 O C B + 1 2')
+		assert_match(/\A0x\h+\n3\n\z/, out)
+		assert_match(/constant folding: 0 nodes folded/, err)
+	end
+end
@@ -0,0 +1,34 @@
+require_relative 'helper'
+
+describe 'Fusion' do
+	include Kn::Cpp
+
+	# Runs `program` with and without fusion, checking they have the same output and status, and returns the stats.
+	def fused(program)
+		expected = knight('--no-fuse', '--stats', '-e', program)
+		actual = knight('--stats', '-e', program)
+
+		assert_equal expected[0], actual[0], program
+		assert_equal expected[2].exitstatus, actual[2].exitstatus, program
+		assert_match(/^fusion: 0 increments, 0 comparisons, 0 sequences, 0 branches$/, expected[1], program)
+
+		actual[1][/^fusion: .*$/]
+	end
+
+	it 'fuses numeric loops' do
+		assert_equal 'fusion: 2 increments, 1 comparisons, 2 sequences, 1 branches',
+			fused('; = i 0 ; = j 10 ; W < i 3 ; = i + i 1 = j - j 2 O j')
+	end
+
+	it 'falls back to the original functions for other values' do
+		assert_equal 'fusion: 1 increments, 1 comparisons, 2 sequences, 0 branches',
+			fused('; = s "a" ; = s + s 1 ; O ? s "a1" O > s 1')
+		assert_equal 'fusion: 0 increments, 1 comparisons, 0 sequences, 1 branches',
+			fused('; = x "1" O I ? x 1 "y" "n"')
+	end
+
+	it 'raises the same errors' do
+		fused('; = x + x 1 O x')
+		fused('; = i 0 W < i y = i + i 1')
+	end
+end
@@ -0,0 +1,15 @@
+require 'minitest/autorun'
+require 'minitest/spec'
+require 'open3'
+
+# Helpers for the tests of this implementation's own features, which the shared spec suite doesn't cover.
+module Kn
+	module Cpp
+		EXECUTABLE = ENV.fetch('KNIGHT') { File.expand_path('../knight', __dir__) }
+
+		# Runs the executable with `args`, returning its output, error output and exit status.
+		def knight(*args, input: '')
+			Open3.capture3(EXECUTABLE, *args, stdin_data: input, binmode: true)
+		end
+	end
+end
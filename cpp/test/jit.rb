@@ -0,0 +1,54 @@
+require_relative 'helper'
+
+describe 'JIT' do
+	include Kn::Cpp
+
+	# Runs `program` with and without the JIT, checking they have the same output and status.
+	def assert_same(program)
+		expected = knight('-e', program)
+		actual = knight('--jit', '-e', program)
+
+		assert_equal expected[0], actual[0], program
+		assert_equal expected[2].exitstatus, actual[2].exitstatus, program
+	end
+
+	# Wraps `body` in a loop that runs three times, which is what gets compiled.
+	def loop(body, result)
+		"; = i 0 ; = x 0 ; W < i 3 ; #{body} = i + i 1 O #{result}"
+	end
+
+	it 'compiles numeric loops' do
+		_, err, _ = knight('--jit', '--stats', '-e', loop('= x + x i', 'x'))
+		assert_match(/jit: 1 loops compiled, 1 entered/, err)
+	end
+
+	it 'matches the other engines on arithmetic' do
+		assert_same loop('= x + * x 3 - i 7', 'x')
+		assert_same loop('= x / - x 100 (+ i 1)', 'x')
+		assert_same loop('= x % - 0 + x 7 (+ i 2)', 'x')
+		assert_same loop('= x I < x 2 ! x & x 5', 'x')
+	end
+
+	it 'wraps around at 63 bits' do
+		assert_same loop('= x * 4611686018427387903 2', 'x')
+		assert_same loop('= x < (* 4611686018427387903 2) 0', 'x')
+		assert_same loop('= x + 4611686018427387903 i', 'x')
+	end
+
+	it 'divides the smallest number by -1' do
+		assert_same loop('= x / (+ (* 4611686018427387903 2) 2) (- 0 1)', 'x')
+		assert_same loop('= x % (+ (* 4611686018427387903 2) 2) (- 0 1)', 'x')
+		assert_same loop('= x / (- 0 7) (- 0 1)', 'x')
+	end
+
+	it 'raises the same errors' do
+		assert_same loop('= x / x 0', 'x')
+		assert_same loop('= x % x 0', 'x')
+		assert_same loop('= x + x y', 'x')
+	end
+
+	it 'falls back to the interpreter for other kinds of values' do
+		assert_same loop('= x + x 1', '+ "x=" x')
+		assert_same "; = x \"1\" #{loop('= x + x 1', 'x')}"
+	end
+end
@@ -0,0 +1,46 @@
+require_relative 'helper'
+
+describe 'Output policies' do
+	include Kn::Cpp
+
+	POLICIES = %w[line block full]
+
+	# Writes 5000 lines of 20 bytes each, which is more than the default buffer holds.
+	LINES = '; = i 0 W < i 5000 ; O "xxxxxxxxxxxxxxxxxxx" = i + i 1'
+
+	# Runs `program` under each policy, checking they all write the same output and exit with the same status.
+	def assert_same(program)
+		expected = knight('-e', program)
+
+		POLICIES.each do |policy|
+			out, _, status = knight("--output=#{policy}", '-e', program)
+
+			assert_equal expected[0], out, "#{policy}: #{program}"
+			assert_equal expected[2].exitstatus, status.exitstatus, "#{policy}: #{program}"
+		end
+	end
+
+	it 'writes the same output under every policy' do
+		assert_same '; O "a" ; O "b\" O 1'
+		assert_same LINES
+	end
+
+	it 'flushes output written before an error' do
+		assert_same '; O "a" ; O "b\" / 1 0'
+		assert_same "; #{LINES} / 1 0"
+	end
+
+	it 'flushes output written before QUIT' do
+		assert_same '; O "a" ; O "b\" Q 3'
+		assert_same "; #{LINES} Q 3"
+	end
+
+	it 'reports how many writes it used' do
+		expected = { 'line' => 5000, 'block' => 2, 'full' => 1 }
+
+		POLICIES.each do |policy|
+			_, err, _ = knight("--output=#{policy}", '--stats', '-e', LINES)
+			assert_match(/^output: 100000 bytes written in #{expected[policy]} syscalls$/, err, policy)
+		end
+	end
+end
@@ -0,0 +1,91 @@
+require_relative 'helper'
+require 'tmpdir'
+require 'fileutils'
+
+describe 'Precompiled files' do
+	include Kn::Cpp
+
+	let(:program) { '; = f B + x 1 ; = x 41 ; O C f O "done"' }
+
+	# The magic bytes, version, payload length and checksum.
+	let(:header_length) { 4 + 4 + 8 + 8 }
+
+	before { @dir = Dir.mktmpdir }
+	after { FileUtils.rm_rf @dir }
+
+	# Compiles `program`, returning the bytes of the precompiled file.
+	def compile
+		path = File.join(@dir, 'program.knc')
+		_, err, status = knight('--compile', path, '-e', program)
+		assert status.success?, err
+		File.binread(path)
+	end
+
+	# Runs the precompiled file `bytes`, returning its output, error output and exit status.
+	def run_compiled(bytes)
+		path = File.join(@dir, 'modified.knc')
+		File.binwrite(path, bytes)
+		knight('-c', path)
+	end
+
+	# Asserts that running `bytes` fails with an error matching `message`.
+	def assert_rejected(bytes, message)
+		out, err, status = run_compiled(bytes)
+		assert_equal '', out
+		assert_equal 1, status.exitstatus
+		assert_match message, err
+	end
+
+	def checksum(payload)
+		payload.each_byte.reduce(0xcbf29ce484222325) { |hash, byte| ((hash ^ byte) * 0x100000001b3) & 0xffff_ffff_ffff_ffff }
+	end
+
+	# Replaces the payload of `bytes` with `payload`, with a header that matches it.
+	def with_payload(bytes, payload)
+		bytes[0, 8] + [payload.bytesize, checksum(payload)].pack('Q<Q<') + payload
+	end
+
+	it 'runs the same as the source' do
+		assert_equal knight('-e', program)[0], run_compiled(compile)[0]
+		assert_equal "42\ndone\n", run_compiled(compile)[0]
+	end
+
+	it 'rejects bad magic' do
+		bytes = compile
+		assert_rejected 'XNC' + bytes[3..], /bad magic/
+		assert_rejected '', /bad magic/
+		assert_rejected bytes[0, header_length - 1], /bad magic/
+	end
+
+	it 'rejects other versions' do
+		bytes = compile
+		bytes[4, 4] = [99].pack('L<')
+		assert_rejected bytes, /unsupported version 99/
+	end
+
+	it 'rejects truncated files' do
+		bytes = compile
+		assert_rejected bytes[0...-1], /wrong length/
+		assert_rejected bytes[0, header_length], /wrong length/
+	end
+
+	it 'rejects corrupted payloads' do
+		bytes = compile
+		bytes[-1] = (bytes[-1].ord ^ 1).chr
+		assert_rejected bytes, /checksum mismatch/
+	end
+
+	it 'rejects payloads that are invalid even with a valid header' do
+		bytes = compile
+		payload = bytes[header_length..]
+
+		assert_rejected with_payload(bytes, payload[0...-1]), /unexpected end of data/
+		assert_rejected with_payload(bytes, payload + "\0"), /trailing data/
+		assert_rejected with_payload(bytes, ''), /unexpected end of data/
+		assert_rejected with_payload(bytes, [0, 99].pack('L<C')), /unknown tag/
+		assert_rejected with_payload(bytes, [0xffffffff].pack('L<')), /too many variables/
+		assert_rejected with_payload(bytes, [2, 0].pack('L<L<')), /too many variables/
+		assert_rejected with_payload(bytes, [0, 6, 'Z'.ord].pack('L<CC')), /unknown function/
+		assert_rejected with_payload(bytes, [0, 5, 0].pack('L<CL<')), /unknown variable/
+	end
+end
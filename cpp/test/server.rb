@@ -0,0 +1,138 @@
+require_relative 'helper'
+require 'socket'
+require 'tmpdir'
+require 'fileutils'
+require 'timeout'
+
+module Kn::Cpp
+	# A response read back from the server.
+	Response = Struct.new :status, :output, :error
+end
+
+describe 'Server' do
+	include Kn::Cpp
+
+	def request(source)
+		[source.bytesize].pack('L<') + source
+	end
+
+	# Parses all the responses in `bytes`.
+	def responses(bytes)
+		responses = []
+
+		until bytes.empty?
+			status, _nanoseconds, length = bytes.unpack('L<Q<L<')
+			output = bytes.byteslice(16, length)
+			bytes = bytes.byteslice(16 + length..)
+
+			length, = bytes.unpack('L<')
+			error = bytes.byteslice(4, length)
+			bytes = bytes.byteslice(4 + length..)
+
+			responses << Kn::Cpp::Response.new(status, output, error)
+		end
+
+		responses
+	end
+
+	# Connects to the server listening at `path`, waiting for it to start.
+	def connect(path)
+		UNIXSocket.new(path)
+	rescue Errno::ENOENT, Errno::ECONNREFUSED
+		sleep 0.01
+		retry
+	end
+
+	# Serves `input` over standard input, returning the responses, error output and exit status.
+	def serve(input)
+		out, err, status = knight('-s', input: input)
+		[responses(out), err, status]
+	end
+
+	it 'answers each request in order' do
+		replies, _, status = serve(request('O "a"') + request('O + 1 2') + request('O "c\\"'))
+
+		assert_equal 0, status.exitstatus
+		assert_equal ["a\n", "3\n", 'c'], replies.map(&:output)
+		assert_equal [0, 0, 0], replies.map(&:status)
+		assert_equal ['', '', ''], replies.map(&:error)
+	end
+
+	it 'runs each program in a fresh interpreter' do
+		replies, _, _ = serve(request('= x 1') + request('O x'))
+
+		assert_equal 0, replies[0].status
+		assert_equal 1, replies[1].status
+		assert_match(/x/, replies[1].error)
+	end
+
+	it 'reports errors and QUIT statuses' do
+		replies, _, status = serve(request('; O "before" / 1 0') + request('Q 7') + request('O') + request(''))
+
+		assert_equal 0, status.exitstatus
+		assert_equal [1, 7, 1, 1], replies.map(&:status)
+		assert_equal "before\n", replies[0].output
+		assert_match(/divide by zero/, replies[0].error)
+		assert_equal '', replies[1].error
+		refute_empty replies[2].error
+		refute_empty replies[3].error
+	end
+
+	it 'rejects truncated requests after answering the earlier ones' do
+		[[0].pack('S<'), [10].pack('L<') + 'O 1', [3].pack('L<') + 'O'].each do |truncated|
+			replies, err, status = serve(request('O 1') + truncated)
+
+			assert_equal ["1\n"], replies.map(&:output)
+			assert_equal 1, status.exitstatus
+			assert_match(/truncated request/, err)
+		end
+	end
+
+	it 'only closes the connection with a malformed request' do
+		path = File.join(Dir.mktmpdir, 'knight.sock')
+		pid = spawn(Kn::Cpp::EXECUTABLE, '-s', path, err: File::NULL)
+
+		begin
+			broken = connect(path)
+			broken.write [10].pack('L<') + 'O'
+			broken.close_write
+			assert_equal '', broken.read
+
+			client = connect(path)
+			client.write request('O "still up"')
+			client.close_write
+			assert_equal ["still up\n"], responses(client.read).map(&:output)
+		ensure
+			Process.kill 'TERM', pid
+			Process.wait pid
+			FileUtils.rm_rf File.dirname(path)
+		end
+	end
+
+	it 'serves more connections at once than it has threads' do
+		path = File.join(Dir.mktmpdir, 'knight.sock')
+		pid = spawn(Kn::Cpp::EXECUTABLE, '--jobs=1', '-s', path, err: File::NULL)
+
+		begin
+			Timeout.timeout(10) do
+				# these stay open, so they'd each hold on to the only thread if connections were run on the pool.
+				open = Array.new(3) { connect(path) }
+				open.each_with_index do |client, index|
+					client.write request("O #{index}")
+					assert_equal ["#{index}\n"], responses(client.read(16 + 2 + 4)).map(&:output)
+				end
+
+				client = connect(path)
+				client.write request('O "not starved"')
+				client.close_write
+				assert_equal ["not starved\n"], responses(client.read).map(&:output)
+
+				open.each(&:close)
+			end
+		ensure
+			Process.kill 'TERM', pid
+			Process.wait pid
+			FileUtils.rm_rf File.dirname(path)
+		end
+	end
+end
@@ -0,0 +1,10 @@
+# Runs the shared spec suite (in `../../test`) against this implementation.
+#
+# The executable is `$KNIGHT`, or `../knight` by default, and it's passed the options in `$KNIGHT_OPTIONS` before each
+# program, so that every engine and optimization can be checked; eg `KNIGHT_OPTIONS=--engine=vm ruby test/spec.rb`.
+$executable_to_test = [
+	ENV.fetch('KNIGHT') { File.expand_path('../knight', __dir__) },
+	*ENV.fetch('KNIGHT_OPTIONS', '').split
+]
+
+load File.expand_path('../../test/runtest', __dir__)